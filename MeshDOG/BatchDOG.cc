@@ -0,0 +1,404 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS BatchDOG - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "BatchDOG.hh"
+#include "MeshKernel.hh"
+#include "HugePageArena.hh"
+#include "MeshLoader.hh"
+#include "ScratchArena.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+/// outcome of one mesh, a row of the summary
+struct BatchDOG::Result
+{
+  bool    ok;
+  size_t  n_vertices, n_faces, n_features, ring_bytes;
+  double  read_seconds, detect_seconds;
+};
+
+
+/// buffers a worker keeps from mesh to mesh
+struct BatchDOG::Worker
+{
+  MeshLoader                 loader;
+  MeshKernel                 kernel;
+  MeshKernel::Field          f, eavg, dog;
+  std::vector<unsigned int>  features;
+  ScratchArena               scratch;    // temporaries of the kernel
+};
+
+
+static double seconds_since(const std::chrono::steady_clock::time_point& _t)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - _t).count();
+}
+
+
+/// file name without directory and extension
+static std::string stem(const std::string& _path)
+{
+  size_t slash = _path.find_last_of('/');
+  std::string name(slash == std::string::npos ? _path : _path.substr(slash+1));
+  return name.substr(0, name.find_last_of('.'));
+}
+
+
+/** output names of _files: the stem, or the file name with the dot as
+    '_' where stems collide (a.obj, a.ply), with the list index appended
+    where that still collides (the same name in two directories); false
+    if two names are still the same **/
+static bool output_names(const std::vector<std::string>& _files, std::vector<std::string>& _names)
+{
+  std::map<std::string, size_t>  count;
+  size_t                         i;
+
+  _names.resize(_files.size());
+  for (i=0; i<_files.size(); ++i)
+    ++count[_names[i] = stem(_files[i])];
+
+  for (i=0; i<_files.size(); ++i)
+    if (count[_names[i]] > 1)
+    {
+      std::string name(_files[i].substr(_files[i].find_last_of('/') + 1));
+      std::replace(name.begin(), name.end(), '.', '_');
+      _names[i] = name;
+    }
+
+  count.clear();
+  for (i=0; i<_files.size(); ++i)
+    ++count[_names[i]];
+
+  for (i=0; i<_files.size(); ++i)
+    if (count[_names[i]] > 1)
+    {
+      std::ostringstream name;
+      name << _names[i] << "." << i;
+      _names[i] = name.str();
+    }
+
+  // a stem that looks like an indexed name, e.g. a_obj.0
+  count.clear();
+  for (i=0; i<_files.size(); ++i)
+    if (++count[_names[i]] > 1)
+    {
+      std::cerr << "two meshes would write " << _names[i] << ".dog, rename " << _files[i] << std::endl;
+      return false;
+    }
+
+  return true;
+}
+
+
+/// ask the kernel to read _path into the page cache in the background
+static void prefetch(const std::string& _path)
+{
+#ifdef POSIX_FADV_WILLNEED
+  int fd = ::open(_path.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+  ::close(fd);
+#else
+  (void)_path;
+#endif
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+BatchDOG::
+BatchDOG()
+  : iters_(10), fraction_(0.95), budget_(0), resolution_(0), radius_(0.0f), rings_(1), geodesic_(0.0f), n_workers_(0), output_("."),
+    weld_(false), weld_epsilon_(0.0f)
+{
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+BatchDOG::
+list_inputs(const char* _path, std::vector<std::string>& _files)
+{
+  struct stat  st;
+  std::string  path(_path);
+
+  _files.clear();
+  if (stat(_path, &st) != 0)
+  {
+    std::cerr << "cannot open " << path << std::endl;
+    return false;
+  }
+
+
+  // directory: the files the loader understands
+  if (S_ISDIR(st.st_mode))
+  {
+    DIR* dir = opendir(_path);
+    if (!dir) return false;
+
+    while (struct dirent* entry = readdir(dir))
+    {
+      std::string file(path + "/" + entry->d_name);
+      if (MeshLoader::can_read(entry->d_name) && stat(file.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+        _files.push_back(file);
+    }
+    closedir(dir);
+
+    std::sort(_files.begin(), _files.end());
+    return true;
+  }
+
+
+  // manifest: one path per line
+  std::ifstream  manifest(_path);
+  std::string    line, base;
+  size_t         slash = path.find_last_of('/');
+
+  if (slash != std::string::npos)
+    base = path.substr(0, slash+1);
+
+  while (std::getline(manifest, line))
+  {
+    line.erase(line.find_last_not_of(" \t\r") + 1);
+    if (line.empty() || line[0] == '#') continue;
+    _files.push_back(line[0] == '/' ? line : base + line);
+  }
+
+  return !manifest.bad();
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+BatchDOG::
+process(const std::string& _file, const std::string& _name, Worker& _w, Result& _result) const
+{
+  std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+
+  _result.ok = false;
+  _result.n_vertices = _result.n_faces = _result.n_features = _result.ring_bytes = 0;
+  _result.read_seconds = _result.detect_seconds = 0.0;
+
+
+  // read
+  if (!_w.loader.read(_file.c_str()))
+  {
+    std::cerr << "cannot read " << _file << std::endl;
+    return;
+  }
+  if (weld_ || _w.loader.is_soup())
+    _w.loader.weld(weld_epsilon_);
+
+  const size_t nv(_w.loader.n_vertices());
+  _result.n_vertices   = nv;
+  _result.n_faces      = _w.loader.n_faces();
+  _result.read_seconds = seconds_since(t);
+  if (nv == 0)
+  {
+    std::cerr << "no vertices in " << _file << std::endl;
+    return;
+  }
+
+
+  // detect, as CompactMesh and PatchDOG do
+  t = std::chrono::steady_clock::now();
+  _w.kernel.set_mesh(_w.loader.points(), nv, _w.loader.faces(), _w.loader.n_faces());
+  _w.kernel.calc_uniform_mean_curvature(_w.f);
+  _w.kernel.calc_edge_average(_w.eavg);
+  if (geodesic_ > 0.0f)
+    _w.kernel.build_geodesic(_w.eavg, geodesic_);
+  else if (rings_ > 1)
+    _w.kernel.build_rings(rings_);
+  _result.ring_bytes = _w.kernel.rings().bytes();
+  _w.kernel.detect_meshdog(iters_, _w.eavg, _w.f, _w.dog);
+  if (budget_)
+    _w.kernel.select_uniform_features(_w.dog, budget_, resolution_, _w.features);
+  else
+    _w.kernel.select_features(_w.dog, fraction_, _w.features);
+  if (radius_ > 0.0f)
+    _w.kernel.suppress_features(_w.dog, _w.eavg, radius_, _w.features);
+
+  _result.n_features     = _w.features.size();
+  _result.detect_seconds = seconds_since(t);
+
+
+  _result.ok = write_features(output_ + "/" + _name + ".dog", _w.loader.points(), _w.features);
+  if (!_result.ok)
+    std::cerr << "cannot write the features of " << _file << std::endl;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+BatchDOG::
+run(const std::vector<std::string>& _files)
+{
+  const long long                        n(_files.size());
+  std::vector<Result>                    results(n);
+  std::vector<std::string>               names;
+  std::atomic<long long>                 next(0);
+  std::chrono::steady_clock::time_point  start = std::chrono::steady_clock::now();
+  int                                    n_workers(1);
+
+  if (!output_names(_files, names))
+    return false;
+
+#ifdef _OPENMP
+  n_workers = n_workers_ > 0 ? n_workers_ : omp_get_max_threads();
+
+  // one mesh per thread, the kernels inside run on one thread each
+  const int max_levels = omp_get_max_active_levels();
+  omp_set_max_active_levels(1);
+#endif
+
+
+  // every worker claims its next mesh before working on the current one,
+  // so that file is read ahead meanwhile
+#pragma omp parallel num_threads(n_workers)
+  {
+    Worker     worker;
+    long long  i = next.fetch_add(1);
+
+    worker.kernel.set_scratch(&worker.scratch);
+
+    while (i < n)
+    {
+      long long j = next.fetch_add(1);
+      if (j < n) prefetch(_files[j]);
+
+      process(_files[i], names[i], worker, results[i]);
+
+      // the page backing while the first mesh's arrays are live
+      if (i == 0)
+        HugePageArena::sample();
+      i = j;
+    }
+  }
+
+#ifdef _OPENMP
+  omp_set_max_active_levels(max_levels);
+#endif
+  const double elapsed = seconds_since(start);
+
+
+  // summary table in input order
+  std::ofstream  summary((output_ + "/summary.txt").c_str());
+  size_t         n_ok(0), n_vertices(0);
+
+  summary << "# mesh\tvertices\tfaces\tfeatures\tread_ms\tdetect_ms\tring_kb\tstatus\toutput\n"
+          << std::fixed << std::setprecision(3);
+  for (long long i=0; i<n; ++i)
+  {
+    const Result& r = results[i];
+    summary << _files[i] << "\t" << r.n_vertices << "\t" << r.n_faces << "\t"
+            << r.n_features << "\t" << r.read_seconds * 1000 << "\t"
+            << r.detect_seconds * 1000 << "\t" << r.ring_bytes / 1024.0 << "\t"
+            << (r.ok ? "ok" : "failed") << "\t" << names[i] << ".dog\n";
+    if (r.ok)
+    {
+      ++n_ok;
+      n_vertices += r.n_vertices;
+    }
+  }
+  summary << "# " << n_ok << " of " << n << " meshes, " << n_vertices << " vertices in "
+          << elapsed << " s with " << n_workers << " workers, "
+          << (elapsed > 0 ? n_ok / elapsed : 0.0) << " meshes/s\n";
+  summary << "# ";
+  HugePageArena::report(summary);
+
+  std::cerr << n_ok << " of " << n << " meshes in " << elapsed << " s, "
+            << (elapsed > 0 ? n_ok / elapsed : 0.0) << " meshes/s" << std::endl;
+
+  if (!summary)
+  {
+    std::cerr << "cannot write " << output_ << "/summary.txt" << std::endl;
+    return false;
+  }
+  return n_ok == (size_t)n;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+BatchDOG::
+write_features(const std::string& _prefix, const float* _points,
+               const std::vector<unsigned int>& _features)
+{
+  std::ofstream ply((_prefix + ".ply").c_str()), txt((_prefix + ".txt").c_str());
+
+  ply << "ply\nformat ascii 1.0\nelement vertex " << _features.size()
+      << "\nproperty float x\nproperty float y\nproperty float z\n"
+      << "element face 0\nproperty list uchar int vertex_indices\nend_header\n";
+  for (unsigned i = 0; i < _features.size(); ++i)
+  {
+    const float* p = _points + 3*_features[i];
+    ply << p[0] << " " << p[1] << " " << p[2] << "\n";
+    txt << _features[i] << "\n";
+  }
+
+  return ply && txt;
+}
+
+
+//=============================================================================
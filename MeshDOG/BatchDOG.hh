@@ -0,0 +1,138 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS BatchDOG
+//
+//=============================================================================
+
+
+#ifndef BATCH_DOG_HH
+#define BATCH_DOG_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class BatchDOG BatchDOG.hh
+    MeshDOG detection over many meshes.
+
+    Every worker thread takes the next mesh of the list, reads it with a
+    MeshLoader and runs the MeshKernel pipeline on it with the OpenMP
+    parallelism inside the mesh switched off, so small meshes do not pay
+    for team startup. While a worker computes, the kernel already reads
+    its next file into the page cache. Each mesh gets its own feature
+    files, the summary table lists vertices, features and timings per
+    mesh and the throughput of the whole batch.
+**/
+
+class BatchDOG
+{
+public:
+
+  BatchDOG();
+
+  /// number of Gaussian convolutions
+  void set_iterations(int _iters) { iters_ = _iters; }
+
+  /// fraction of vertices below the DoG threshold
+  void set_fraction(double _fraction) { fraction_ = _fraction; }
+
+  /// at most _budget features per mesh spread over a grid instead, with
+  /// _resolution cells along the longest side (0: from the budget)
+  void set_uniform(size_t _budget, unsigned int _resolution)
+  { budget_ = _budget; resolution_ = _resolution; }
+
+  /// drop features within _radius average edge lengths of a stronger one
+  void set_radius(float _radius) { radius_ = _radius; }
+
+  /// convolve over the _k-rings, or within _radius average edge lengths
+  /// along the edges, with fewer passes; see RingTable
+  void set_rings(unsigned int _k) { rings_ = _k; }
+  void set_geodesic(float _radius) { geodesic_ = _radius; }
+
+  /// number of meshes processed at the same time, 0 for one per thread
+  void set_workers(int _n) { n_workers_ = _n; }
+
+  /// directory the feature files and the summary are written to
+  void set_output(const std::string& _dir) { output_ = _dir; }
+
+  /// weld all meshes, not only triangle soups
+  void set_weld_epsilon(float _eps) { weld_ = true; weld_epsilon_ = _eps; }
+
+  /** the mesh files MeshLoader reads in directory _path, sorted by name,
+      or the lines of the manifest file _path, relative to its directory **/
+  static bool list_inputs(const char* _path, std::vector<std::string>& _files);
+
+  /** detect the features of all files, write <output>/<name>.dog.ply and
+      .dog.txt and <output>/summary.txt; false if a mesh failed. The name
+      is the file name without extension, inputs that would share it
+      keep the extension as _ext, then add their index in the list; the
+      summary lists the name of every mesh. **/
+  bool run(const std::vector<std::string>& _files);
+
+  /// feature positions to _prefix.ply, their indices to _prefix.txt
+  static bool write_features(const std::string& _prefix, const float* _points,
+                             const std::vector<unsigned int>& _features);
+
+
+private:
+
+  struct Result;
+  struct Worker;
+
+  /// read and detect one mesh with the buffers of _worker, write its
+  /// features under _name
+  void process(const std::string& _file, const std::string& _name, Worker& _worker,
+               Result& _result) const;
+
+  int          iters_;
+  double       fraction_;
+  size_t       budget_;
+  unsigned int resolution_;
+  float        radius_;
+  unsigned int rings_;
+  float        geodesic_;
+  int          n_workers_;
+  std::string  output_;
+  bool         weld_;
+  float        weld_epsilon_;
+};
+
+
+//=============================================================================
+#endif // BATCH_DOG_HH defined
+//=============================================================================
@@ -0,0 +1,401 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS CompactMesh - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "CompactMesh.hh"
+#include "MeshKernel.hh"
+#include <algorithm>
+#include <iostream>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+// per vertex the factor (exp(d) - 1) exp(d) bounding how far its Gaussian
+// ring average moves, relative to the spread of the ring around it, with
+// edge lengths off by _dl and e_avg off by _dl plus its half precision
+// rounding; see CompactMesh
+static void weight_factors(const MeshKernel& _kernel, const MeshKernel::Field& _eavg,
+                           float _eavg_scale, float _dl, std::vector<float>& _factors)
+{
+  const float  cbrt2(1.25992105f);
+
+  _factors.assign(_kernel.n_vertices(), 0.0f);
+  for (size_t v=0; v<_kernel.n_vertices(); ++v)
+  {
+    if (!_kernel.valence(v)) continue;
+
+    const float  de(_dl + std::max(ldexpf(_eavg[v], -11), ldexpf(_eavg_scale, -25)));
+    if (!(_eavg[v] > de))
+    {
+      _factors[v] = FLT_MAX;
+      continue;
+    }
+
+    const float   theta(cbrt2 * _eavg[v]);
+    const float   tmin(cbrt2 * (_eavg[v] - de)), tmax(cbrt2 * (_eavg[v] + de));
+    const float*  p(_kernel.point(v));
+    float         d(0);
+
+    for (unsigned int i=_kernel.ring_begin(v); i<_kernel.ring_end(v); ++i)
+    {
+      const float*  q(_kernel.point(_kernel.neighbor(i)));
+      const float   l(sqrtf((p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) + (p[2]-q[2])*(p[2]-q[2])));
+      const float   lmin(std::max(0.0f, l - _dl)), lmax(l + _dl);
+      const float   e(l*l / (2*theta*theta));
+
+      d = std::max(d, std::max(lmax*lmax / (2*tmin*tmin) - e, e - lmin*lmin / (2*tmax*tmax)));
+    }
+    _factors[v] = std::min(FLT_MAX, (expf(d) - 1) * expf(d));
+  }
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+CompactMesh::
+CompactMesh()
+  : band_(0), n_uncertain_(0)
+{
+  for (int k=0; k<3; ++k)
+    bbmin_[k] = step_[k] = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+CompactMesh::Half
+CompactMesh::
+to_half(float _f)
+{
+  uint32_t x;
+  memcpy(&x, &_f, sizeof(x));
+
+  const uint32_t  sign((x >> 16) & 0x8000);
+  uint32_t        mant(x & 0x7fffff), h, rem, half;
+  const int       e(int((x >> 23) & 0xff) - 127 + 15);
+
+  if (((x >> 23) & 0xff) == 0xff)  // inf, nan
+    return sign | 0x7c00 | (mant ? 0x200 : 0);
+  if (e >= 31)                     // overflow
+    return sign | 0x7c00;
+
+  if (e <= 0)                      // subnormal or zero
+  {
+    if (e < -10) return sign;
+    mant |= 0x800000;
+    h    = mant >> (14 - e);
+    rem  = mant & ((1u << (14 - e)) - 1);
+    half = 1u << (13 - e);
+  }
+  else
+  {
+    h    = (e << 10) | (mant >> 13);
+    rem  = mant & 0x1fff;
+    half = 0x1000;
+  }
+
+  // round to nearest even, a carry into the exponent is correct
+  if (rem > half || (rem == half && (h & 1)))
+    ++h;
+  return sign | h;
+}
+
+
+float
+CompactMesh::
+from_half(Half _h)
+{
+  const uint32_t  sign(uint32_t(_h & 0x8000) << 16), mant(_h & 0x3ff);
+  const int       e((_h >> 10) & 0x1f);
+  uint32_t        x;
+  float           f;
+
+  if (e == 0)
+  {
+    f = ldexpf(float(mant), -24);
+    return sign ? -f : f;
+  }
+  if (e == 31)
+    x = sign | 0x7f800000 | (mant << 13);
+  else
+    x = sign | ((e - 15 + 127) << 23) | (mant << 13);
+
+  memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+CompactMesh::
+set_mesh(const float* _points, size_t _n_vertices,
+         const unsigned int* _faces, size_t _n_faces)
+{
+  float bbmax[3];
+
+  for (int k=0; k<3; ++k)
+  {
+    bbmin_[k] = _n_vertices ? _points[k] : 0;
+    bbmax[k]  = bbmin_[k];
+  }
+  for (size_t v=0; v<_n_vertices; ++v)
+    for (int k=0; k<3; ++k)
+    {
+      bbmin_[k] = std::min(bbmin_[k], _points[3*v+k]);
+      bbmax[k]  = std::max(bbmax[k],  _points[3*v+k]);
+    }
+  for (int k=0; k<3; ++k)
+    step_[k] = (bbmax[k] - bbmin_[k]) / 65535;
+
+
+  points_.resize(3*_n_vertices);
+  for (size_t i=0; i<3*_n_vertices; ++i)
+  {
+    const int k(i % 3);
+    points_[i] = step_[k] > 0 ? (unsigned short)std::min(65535.0f, floorf((_points[i] - bbmin_[k]) / step_[k] + 0.5f)) : 0;
+  }
+
+  faces_.assign(_faces, _faces + 3*_n_faces);
+  fields_.clear();
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+CompactMesh::
+points(std::vector<float>& _points) const
+{
+  _points.resize(points_.size());
+  for (size_t i=0; i<points_.size(); ++i)
+    _points[i] = bbmin_[i % 3] + points_[i] * step_[i % 3];
+}
+
+
+float
+CompactMesh::
+position_error() const
+{
+  return std::max(step_[0], std::max(step_[1], step_[2])) / 2;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+CompactMesh::
+uniform_smooth(unsigned int _iters)
+{
+  const size_t                     nv(n_vertices());
+  const std::vector<unsigned int>  faces(faces_);
+  std::vector<float>               pts;
+  MeshKernel                       kernel;
+
+  if (nv == 0) return;
+
+  points(pts);
+  kernel.set_mesh(&pts[0], nv, faces.empty() ? 0 : &faces[0], n_faces());
+  kernel.uniform_smooth(_iters);
+  for (size_t v=0; v<nv; ++v)
+    for (int k=0; k<3; ++k)
+      pts[3*v+k] = kernel.point(v)[k];
+
+  set_mesh(&pts[0], nv, faces.empty() ? 0 : &faces[0], faces.size() / 3);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+CompactMesh::
+set_field(const std::string& _name, const float* _data, size_t _n)
+{
+  Field&  field(fields_[_name]);
+  float   vmax(0);
+
+  // scale by the largest finite magnitude, so the field cannot overflow
+  for (size_t i=0; i<_n; ++i)
+    if (fabsf(_data[i]) <= FLT_MAX)
+      vmax = std::max(vmax, fabsf(_data[i]));
+  field.scale = vmax > 0 ? vmax : 1.0f;
+
+  field.data.resize(_n);
+  for (size_t i=0; i<_n; ++i)
+    field.data[i] = to_half(_data[i] / field.scale);
+}
+
+
+bool
+CompactMesh::
+field(const std::string& _name, std::vector<float>& _data) const
+{
+  std::map<std::string, Field>::const_iterator f = fields_.find(_name);
+  if (f == fields_.end()) return false;
+
+  _data.resize(f->second.data.size());
+  for (size_t i=0; i<_data.size(); ++i)
+    _data[i] = from_half(f->second.data[i]) * f->second.scale;
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+CompactMesh::
+detect(int _iters, double _fraction, std::vector<unsigned int>& _features)
+{
+  const size_t        nv(n_vertices());
+  std::vector<float>  pts, stored;
+  MeshKernel          kernel;
+  MeshKernel::Field   curv, eavg, f, dog;
+
+  _features.clear();
+  band_ = 0;
+  n_uncertain_ = 0;
+  if (nv == 0) return;
+
+  points(pts);
+  kernel.set_mesh(&pts[0], nv, faces_.empty() ? 0 : &faces_[0], n_faces());
+
+
+  // inputs: once computed they are kept in half precision
+  if (!fields_.count("curvature"))
+  {
+    kernel.calc_uniform_mean_curvature(curv);
+    set_field("curvature", &curv[0], nv);
+  }
+  if (!fields_.count("eavg"))
+  {
+    kernel.calc_edge_average(eavg);
+    set_field("eavg", &eavg[0], nv);
+  }
+  field("curvature", stored);
+  f.assign(stored.begin(), stored.end());
+  field("eavg", stored);
+  eavg.assign(stored.begin(), stored.end());
+
+
+  // convolutions in single precision; after each one the error of f
+  // grows by the largest weight factor times the spread of a ring
+  // around its new average, widened by the error of the ring values
+  const float  e(position_error());
+  float        error(sqrtf(3.0f) * e + ldexpf(fields_["curvature"].scale, -11)), previous(error);
+  std::vector<float>  factors;
+  MeshKernel::Field   last;
+
+  weight_factors(kernel, eavg, fields_["eavg"].scale, 2 * sqrtf(3.0f) * e, factors);
+  dog.assign(nv, 0.0f);
+  for (int i=0; i<_iters; ++i)
+  {
+    float e_w(0);
+
+    last = f;
+    kernel.gaussian_conv_step(eavg, f, dog);
+    for (size_t v=0; v<nv; ++v)
+    {
+      float spread(0);
+      for (unsigned int j=kernel.ring_begin(v); j<kernel.ring_end(v); ++j)
+        spread = std::max(spread, fabsf(last[kernel.neighbor(j)] - f[v]));
+      e_w = std::max(e_w, std::min(FLT_MAX, factors[v] * (spread + 2 * error)));
+    }
+    previous = error;
+    error    = std::min(FLT_MAX, error + e_w);
+  }
+
+  for (size_t v=0; v<nv; ++v)
+    if (isnan(dog[v])) dog[v] = 0.0f;
+  set_field("dog", &dog[0], nv);
+
+  std::vector<float> sorted(dog.begin(), dog.end());
+  const size_t k = std::min(nv-1, (size_t)(nv * _fraction));
+  std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+  const float threshold = sorted[k];
+
+
+  // features and the band of the error bound around the threshold, a
+  // DoG value is off by the errors of the last two levels
+  band_ = std::min(FLT_MAX, 2 * (error + previous));
+  for (size_t v=0; v<nv; ++v)
+    if (kernel.valence(v))
+    {
+      if (dog[v] >= threshold)
+        _features.push_back(v);
+      if (fabsf(dog[v] - threshold) <= band_)
+        ++n_uncertain_;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+size_t
+CompactMesh::
+bytes() const
+{
+  size_t b = points_.size() * sizeof(unsigned short) + faces_.size() * sizeof(unsigned int);
+  for (std::map<std::string, Field>::const_iterator f=fields_.begin(); f!=fields_.end(); ++f)
+    b += f->second.data.size() * sizeof(Half);
+  return b;
+}
+
+
+size_t
+CompactMesh::
+full_bytes() const
+{
+  size_t b = points_.size() * sizeof(float) + faces_.size() * sizeof(unsigned int);
+  for (std::map<std::string, Field>::const_iterator f=fields_.begin(); f!=fields_.end(); ++f)
+    b += f->second.data.size() * sizeof(float);
+  return b;
+}
+
+
+//=============================================================================
@@ -0,0 +1,155 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS CompactMesh
+//
+//=============================================================================
+
+
+#ifndef COMPACT_MESH_HH
+#define COMPACT_MESH_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class CompactMesh CompactMesh.hh
+    Resident mesh with 16-bit positions and half precision fields.
+
+    Positions are quantized to 16 bits per axis relative to the bounding
+    box, scalar fields (curvature, e_avg, DoG) are stored as IEEE half
+    floats scaled by their largest magnitude. detect() decodes into a
+    MeshKernel and accumulates in single precision, the decoded fields
+    are only its input. With e = box extent / 131070 the largest error
+    of a coordinate:
+
+    - a position is off by at most e per axis
+    - edge lengths and e_avg by at most 2 sqrt(3) e
+    - the uniform curvature by at most sqrt(3) e, plus 2^-11 of the
+      field maximum once it was stored in half precision; this is the
+      error e_0 of the input f
+    - the Gaussian weights of a ring change by a factor within
+      [exp(-d), exp(d)], d from the largest change of l^2 / 2 theta^2
+      with the edge length l off by 2 sqrt(3) e and theta by that of
+      e_avg, also in half precision. The normalized average g of the
+      ring then moves by at most (exp(d) - 1) exp(d) times the largest
+      |f_j - g| of the ring.
+    - an average does not increase the error of its inputs, so level n
+      is off by e_n = e_n-1 plus the largest such move, which detect()
+      takes from the ring values widened by 2 e_n-1; a DoG value, the
+      difference of the last two levels, by e_n + e_n-1
+    - the threshold, an order statistic of the DoG values, moves by at
+      most the same amount
+
+    So the features equal those of the single precision pipeline except
+    for vertices whose DoG lies within 2 (e_n + e_n-1) of the threshold.
+    detect() reports that band and the number of vertices inside it; it
+    covers most vertices once e is not much smaller than the edges.
+**/
+
+class CompactMesh
+{
+public:
+
+  typedef unsigned short Half;
+
+  CompactMesh();
+
+  /// quantize positions, keep the triangles, drop all fields
+  void set_mesh(const float* _points, size_t _n_vertices,
+                const unsigned int* _faces, size_t _n_faces);
+
+  size_t n_vertices() const { return points_.size() / 3; }
+  size_t n_faces()    const { return faces_.size() / 3; }
+
+  /// decoded positions, xyz per vertex
+  void points(std::vector<float>& _points) const;
+
+  /// largest error of a decoded coordinate
+  float position_error() const;
+
+  /// store a field in half precision
+  void set_field(const std::string& _name, const float* _data, size_t _n);
+
+  /// decoded field, false if there is none of this name
+  bool field(const std::string& _name, std::vector<float>& _data) const;
+
+  /// uniform Laplacian smoothing of the decoded positions, which are
+  /// quantized again; drops all fields
+  void uniform_smooth(unsigned int _iters);
+
+  /// MeshDOG features, vertices with the largest (1-_fraction) DoG values;
+  /// curvature and e_avg are computed once and kept as fields
+  void detect(int _iters, double _fraction, std::vector<unsigned int>& _features);
+
+  /// half width of the band around the threshold in which features may
+  /// differ from a single precision run, and the vertices inside it,
+  /// both of the last detect()
+  float  feature_band() const { return band_; }
+  size_t n_uncertain() const { return n_uncertain_; }
+
+  /// bytes held, and what single precision storage would take
+  size_t bytes() const;
+  size_t full_bytes() const;
+
+
+  /// IEEE half float conversions, round to nearest even
+  static Half  to_half(float _f);
+  static float from_half(Half _h);
+
+
+private:
+
+  struct Field
+  {
+    float              scale;
+    std::vector<Half>  data;
+  };
+
+  float                         bbmin_[3], step_[3];
+  std::vector<unsigned short>   points_;
+  std::vector<unsigned int>     faces_;
+  std::map<std::string, Field>  fields_;
+  float                         band_;
+  size_t                        n_uncertain_;
+};
+
+
+//=============================================================================
+#endif // COMPACT_MESH_HH defined
+//=============================================================================
@@ -0,0 +1,622 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS DaemonDOG - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "DaemonDOG.hh"
+#include "CompactMesh.hh"
+#include "MeshKernel.hh"
+#include "MeshLoader.hh"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+/// a cached mesh and its fields, curv and eavg are empty when stale;
+/// in compact mode only compact holds the mesh and its fields
+struct DaemonDOG::Entry
+{
+  std::string        path;
+  time_t             mtime;
+  off_t              size;
+  bool               is_compact;
+  CompactMesh        compact;
+  MeshKernel         kernel;
+  MeshKernel::Field  curv, eavg, f, dog;
+  int                level;      // convolutions f has had, -1 for none
+  unsigned int       smoothed;   // smoothing steps applied to the file
+  unsigned int       rings;      // ring table of kernel, 1 for none
+  float              geodesic;   // or its geodesic radius, 0 for none
+
+  size_t n_vertices() const
+  {
+    return is_compact ? compact.n_vertices() : kernel.n_vertices();
+  }
+
+  size_t bytes() const
+  {
+    if (is_compact) return compact.bytes();
+    return kernel.bytes() + (curv.capacity() + eavg.capacity() + f.capacity()
+                             + dog.capacity()) * sizeof(float);
+  }
+};
+
+
+/// fill a sockaddr_un, false if the path does not fit
+static bool socket_address(const char* _socket, sockaddr_un& _addr)
+{
+  memset(&_addr, 0, sizeof(_addr));
+  _addr.sun_family = AF_UNIX;
+  if (strlen(_socket) >= sizeof(_addr.sun_path))
+  {
+    std::cerr << "socket path too long: " << _socket << std::endl;
+    return false;
+  }
+  strcpy(_addr.sun_path, _socket);
+  return true;
+}
+
+
+/// write all of _data, false if the peer went away
+static bool write_all(int _fd, const std::string& _data)
+{
+  const char* p(_data.data());
+  size_t      n(_data.size());
+
+  while (n)
+  {
+    ssize_t w = ::write(_fd, p, n);
+    if (w < 0 && errno == EINTR) continue;
+    if (w <= 0) return false;
+    p += w;
+    n -= w;
+  }
+  return true;
+}
+
+
+/// _text as a whole number in [_min, _max], false if it is not
+static bool parse_count(const char* _text, long _min, long _max, long& _value)
+{
+  char* end;
+  errno  = 0;
+  _value = strtol(_text, &end, 10);
+  return end != _text && *end == 0 && errno == 0 && _value >= _min && _value <= _max;
+}
+
+
+/// _text as a finite number in [_min, _max], false if it is not
+static bool parse_real(const char* _text, double _min, double _max, double& _value)
+{
+  char* end;
+  errno  = 0;
+  _value = strtod(_text, &end);
+  return end != _text && *end == 0 && errno == 0 && _value >= _min && _value <= _max;
+}
+
+
+// more convolutions or smoothing steps than any mesh needs, a request
+// beyond keeps the daemon busy for hours
+static const long max_steps = 100000;
+static const long max_rings = 64;
+static const long max_grid  = 1 << 16;
+
+
+//-----------------------------------------------------------------------------
+
+
+DaemonDOG::
+DaemonDOG()
+  : iters_(10), budget_(size_t(1) << 30), weld_(false), weld_epsilon_(0.0f),
+    compact_(false), stop_(false)
+{
+}
+
+
+DaemonDOG::
+~DaemonDOG()
+{
+  for (std::list<Entry*>::iterator e=cache_.begin(); e!=cache_.end(); ++e)
+    delete *e;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+DaemonDOG::Entry*
+DaemonDOG::
+lookup(const std::string& _path, bool& _loaded)
+{
+  struct stat                  st;
+  std::list<Entry*>::iterator  e;
+
+  _loaded = false;
+  if (stat(_path.c_str(), &st) != 0)
+    return 0;
+
+  for (e=cache_.begin(); e!=cache_.end(); ++e)
+    if ((*e)->path == _path)
+      break;
+
+  // still the file that was loaded
+  if (e != cache_.end() && (*e)->mtime == st.st_mtime && (*e)->size == st.st_size)
+  {
+    cache_.splice(cache_.begin(), cache_, e);
+    return cache_.front();
+  }
+
+  if (e != cache_.end())
+  {
+    delete *e;
+    cache_.erase(e);
+  }
+
+  // smoothing of an earlier version of the file is void
+  std::map<std::string, Smoothing>::iterator s = smoothing_.find(_path);
+  if (s != smoothing_.end() && (s->second.mtime != st.st_mtime || s->second.size != st.st_size))
+  {
+    smoothing_.erase(s);
+    s = smoothing_.end();
+  }
+
+
+  // load
+  MeshLoader loader;
+  if (!loader.read(_path.c_str()))
+    return 0;
+  if (weld_ || loader.is_soup())
+    loader.weld(weld_epsilon_);
+
+  Entry* entry    = new Entry;
+  entry->path     = _path;
+  entry->mtime    = st.st_mtime;
+  entry->size     = st.st_size;
+  entry->level    = -1;
+  entry->smoothed = 0;
+  entry->rings    = 1;
+  entry->geodesic = 0.0f;
+  entry->is_compact = compact_;
+  if (compact_)
+    entry->compact.set_mesh(loader.points(), loader.n_vertices(), loader.faces(), loader.n_faces());
+  else
+  {
+    entry->kernel.set_scratch(&scratch_);
+    entry->kernel.set_mesh(loader.points(), loader.n_vertices(), loader.faces(), loader.n_faces());
+  }
+
+  // evicted after a smooth, repeat the steps
+  if (s != smoothing_.end())
+  {
+    entry->smoothed = s->second.steps;
+    if (compact_)
+      entry->compact.uniform_smooth(entry->smoothed);
+    else
+      entry->kernel.uniform_smooth(entry->smoothed);
+  }
+
+  cache_.push_front(entry);
+  _loaded = true;
+  return entry;
+}
+
+
+void
+DaemonDOG::
+trim()
+{
+  size_t total(0);
+  for (std::list<Entry*>::iterator e=cache_.begin(); e!=cache_.end(); ++e)
+    total += (*e)->bytes();
+
+  while (total > budget_ && cache_.size() > 1)
+  {
+    total -= cache_.back()->bytes();
+    delete cache_.back();
+    cache_.pop_back();
+  }
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+DaemonDOG::
+execute(const std::string& _request, std::string& _reply)
+{
+  std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+  std::istringstream                    in(_request);
+  std::ostringstream                    status, data;
+  std::string                           command, path, arg;
+  int                                   iters(iters_);
+  double                                fraction(0.95), real;
+  unsigned int                          steps(1), grid(0), rings(1);
+  size_t                                budget(0);
+  float                                 radius(0.0f), geodesic(0.0f);
+  long                                  count;
+  bool                                  loaded, valid;
+
+  in >> command >> path;
+  while (in >> arg)
+  {
+    // after the '=', the whole argument for a bare number
+    const char* value = arg.c_str() + arg.find('=') + 1;
+
+    if (arg.compare(0, 6, "iters=") == 0)
+    {
+      valid = parse_count(value, 0, max_steps, count);
+      iters = count;
+    }
+    else if (arg.compare(0, 11, "percentile=") == 0)
+    {
+      // 95 and 0.95 mean the same
+      valid = parse_real(value, 0.0, 100.0, fraction);
+      if (fraction > 1.0) fraction /= 100.0;
+    }
+    else if (arg.compare(0, 7, "budget=") == 0)
+    {
+      valid  = parse_count(value, 0, LONG_MAX, count);
+      budget = count;
+    }
+    else if (arg.compare(0, 5, "grid=") == 0)
+    {
+      valid = parse_count(value, 0, max_grid, count);
+      grid  = count;
+    }
+    else if (arg.compare(0, 7, "radius=") == 0)
+    {
+      valid  = parse_real(value, 0.0, HUGE_VAL, real);
+      radius = real;
+    }
+    else if (arg.compare(0, 6, "rings=") == 0)
+    {
+      valid = parse_count(value, 1, max_rings, count);
+      rings = count;
+    }
+    else if (arg.compare(0, 9, "geodesic=") == 0)
+    {
+      valid    = parse_real(value, 0.0, HUGE_VAL, real);
+      geodesic = real;
+    }
+    else if (arg.compare(0, 6, "steps=") == 0 ||
+             (command == "smooth" && arg.find('=') == std::string::npos))
+    {
+      valid = parse_count(value, 0, max_steps, count);
+      steps = count;
+    }
+    else
+    {
+      _reply = "error unknown argument " + arg + "\n";
+      return;
+    }
+
+    if (!valid)
+    {
+      _reply = "error invalid value " + arg + "\n";
+      return;
+    }
+  }
+  if (geodesic > 0.0f)
+    rings = 1;
+
+
+  if (command == "detect" || command == "smooth")
+  {
+    Entry* e = lookup(path, loaded);
+    if (!e)
+    {
+      _reply = "error cannot read " + path + "\n";
+      return;
+    }
+
+    if (command == "smooth")
+    {
+      if (e->is_compact)
+        e->compact.uniform_smooth(steps);
+      else
+        e->kernel.uniform_smooth(steps);
+      e->smoothed += steps;
+      Smoothing& s = smoothing_[path];
+      s.mtime = e->mtime;
+      s.size  = e->size;
+      s.steps = e->smoothed;
+      e->rings    = 1;
+      e->geodesic = 0.0f;
+      MeshKernel::Field().swap(e->curv);
+      MeshKernel::Field().swap(e->eavg);
+      MeshKernel::Field().swap(e->f);
+      MeshKernel::Field().swap(e->dog);
+      e->level = -1;
+
+      status << "ok " << e->smoothed << " smoothing steps";
+    }
+    else if (e->is_compact)
+    {
+      std::vector<unsigned int> features;
+
+      if (budget || radius > 0.0f || rings > 1 || geodesic > 0.0f)
+      {
+        _reply = "error budget, radius, rings and geodesic need a daemon without -compact\n";
+        return;
+      }
+
+      e->compact.detect(iters, fraction, features);
+      status << "ok " << features.size() << " features, " << e->compact.n_uncertain()
+             << " within " << e->compact.feature_band() << " of the threshold";
+      for (size_t i=0; i<features.size(); ++i)
+        data << (i ? " " : "") << features[i];
+      data << "\n";
+    }
+    else
+    {
+      std::vector<unsigned int> features;
+
+      if (e->curv.empty())
+      {
+        e->kernel.calc_uniform_mean_curvature(e->curv);
+        e->kernel.calc_edge_average(e->eavg);
+        e->level = -1;
+      }
+
+      // the ring table of the request, the levels start over with it
+      if (rings != e->rings || geodesic != e->geodesic)
+      {
+        e->kernel.clear_rings();
+        if (geodesic > 0.0f)
+          e->kernel.build_geodesic(e->eavg, geodesic);
+        else if (rings > 1)
+          e->kernel.build_rings(rings);
+        e->rings    = rings;
+        e->geodesic = geodesic;
+        e->level    = -1;
+      }
+
+      // continue from the cached level, start over for fewer iterations;
+      // the wide passes of a table are fixed by the iterations
+      if (!e->kernel.rings().empty())
+      {
+        if (e->level != iters)
+        {
+          e->f = e->curv;
+          e->kernel.detect_meshdog(iters, e->eavg, e->f, e->dog);
+          e->level = iters;
+        }
+      }
+      else
+      {
+        if (e->level < 0 || e->level > iters)
+        {
+          e->f = e->curv;
+          e->dog.assign(e->kernel.n_vertices(), 0.0f);
+          e->level = 0;
+        }
+        for (; e->level < iters; ++e->level)
+          e->kernel.gaussian_conv_step(e->eavg, e->f, e->dog);
+      }
+
+      if (budget)
+        e->kernel.select_uniform_features(e->dog, budget, grid, features);
+      else
+        e->kernel.select_features(e->dog, fraction, features);
+      if (radius > 0.0f)
+        e->kernel.suppress_features(e->dog, e->eavg, radius, features);
+
+      status << "ok " << features.size() << " features";
+      for (size_t i=0; i<features.size(); ++i)
+        data << (i ? " " : "") << features[i];
+      data << "\n";
+    }
+
+    status << ", " << (loaded ? "loaded" : "warm");
+  }
+  else if (command == "drop")
+  {
+    smoothing_.erase(path);
+    for (std::list<Entry*>::iterator e=cache_.begin(); e!=cache_.end(); ++e)
+      if ((*e)->path == path)
+      {
+        delete *e;
+        cache_.erase(e);
+        break;
+      }
+    status << "ok";
+  }
+  else if (command == "stats")
+  {
+    size_t total(0);
+    for (std::list<Entry*>::iterator e=cache_.begin(); e!=cache_.end(); ++e)
+    {
+      total += (*e)->bytes();
+      data << (*e)->path << " " << (*e)->n_vertices() << " vertices, "
+           << (*e)->bytes() << " bytes, level " << (*e)->level
+           << ", smoothed " << (*e)->smoothed << "\n";
+    }
+    status << "ok " << cache_.size() << " meshes, " << total << " of " << budget_ << " bytes";
+  }
+  else if (command == "shutdown")
+  {
+    stop_ = true;
+    status << "ok";
+  }
+  else
+  {
+    _reply = "error unknown command " + command + "\n";
+    return;
+  }
+
+  status << ", " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count()
+         << " ms\n";
+  _reply = status.str() + data.str();
+  trim();
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+DaemonDOG::
+serve_connection(int _fd)
+{
+  std::string  buffer, reply;
+  char         chunk[4096];
+  size_t       eol;
+  ssize_t      n;
+
+  while (!stop_ && (n = ::read(_fd, chunk, sizeof(chunk))) != 0)
+  {
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+      return;
+    }
+    buffer.append(chunk, n);
+
+    while (!stop_ && (eol = buffer.find('\n')) != std::string::npos)
+    {
+      std::string request(buffer, 0, eol);
+      buffer.erase(0, eol + 1);
+      if (request.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+      execute(request, reply);
+      if (!write_all(_fd, reply)) return;
+    }
+  }
+
+  // a last request without newline
+  if (!stop_ && buffer.find_first_not_of(" \t\r") != std::string::npos)
+  {
+    execute(buffer, reply);
+    write_all(_fd, reply);
+  }
+}
+
+
+bool
+DaemonDOG::
+serve(const char* _socket)
+{
+  sockaddr_un  addr;
+  int          fd;
+
+  if (!socket_address(_socket, addr))
+    return false;
+
+  // a stale socket of an earlier run
+  unlink(_socket);
+
+  if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+      bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+      listen(fd, 16) != 0)
+  {
+    std::cerr << "cannot listen on " << _socket << ": " << strerror(errno) << std::endl;
+    if (fd >= 0) close(fd);
+    return false;
+  }
+
+  // a client closing early must not kill the daemon
+  signal(SIGPIPE, SIG_IGN);
+  std::cerr << "serving on " << _socket << std::endl;
+
+  stop_ = false;
+  while (!stop_)
+  {
+    int client = accept(fd, 0, 0);
+    if (client < 0)
+    {
+      if (errno == EINTR) continue;
+      std::cerr << "accept failed: " << strerror(errno) << std::endl;
+      break;
+    }
+    serve_connection(client);
+    close(client);
+  }
+
+  close(fd);
+  unlink(_socket);
+  return stop_;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+DaemonDOG::
+query(const char* _socket, const std::string& _request, std::ostream& _os)
+{
+  sockaddr_un  addr;
+  char         chunk[4096];
+  ssize_t      n;
+  int          fd;
+
+  if (!socket_address(_socket, addr))
+    return false;
+
+  if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+      connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0)
+  {
+    std::cerr << "cannot connect to " << _socket << ": " << strerror(errno) << std::endl;
+    if (fd >= 0) close(fd);
+    return false;
+  }
+
+  // one request, then read the answer until the daemon closes
+  bool ok = write_all(fd, _request + "\n") && shutdown(fd, SHUT_WR) == 0;
+  while (ok && ((n = ::read(fd, chunk, sizeof(chunk))) > 0 || (n < 0 && errno == EINTR)))
+    if (n > 0) _os.write(chunk, n);
+
+  close(fd);
+  return ok && _os;
+}
+
+
+//=============================================================================
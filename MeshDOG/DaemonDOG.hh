@@ -0,0 +1,164 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS DaemonDOG
+//
+//=============================================================================
+
+
+#ifndef DAEMON_DOG_HH
+#define DAEMON_DOG_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include "ScratchArena.hh"
+#include <iosfwd>
+#include <list>
+#include <map>
+#include <string>
+#include <stddef.h>
+#include <sys/types.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class DaemonDOG DaemonDOG.hh
+    MeshDOG detection served on a UNIX domain socket.
+
+    Requests are text lines, one command each, answered with a status
+    line that starts with "ok" or "error":
+
+      detect <mesh> [iters=N] [percentile=p] [budget=k [grid=r]] [radius=r]
+             [rings=k | geodesic=r]             features, on a second line
+      smooth <mesh> [steps=]k                   uniform Laplacian steps
+      drop <mesh>                               forget a mesh
+      stats                                     cached meshes and bytes
+      shutdown                                  stop serving
+
+    With a budget the features are spread over a uniform grid instead
+    of cut at the percentile, see FeatureGrid. A radius drops features
+    within r average edge lengths of a stronger one. Rings and geodesic
+    convolve over the k-rings or within r average edge lengths in fewer
+    wide passes, as BatchDOG does; see RingTable. Any other argument is
+    an error.
+
+    Meshes stay loaded with their adjacency, curvature, e_avg and the
+    last DoG level in an LRU cache limited to a memory budget. A repeated
+    detect only selects the features again, more iterations continue
+    from the cached level; with a ring table, whose passes depend on
+    the iterations, only the same iterations are reused. The table is
+    cached with the mesh. A mesh is reloaded when its file changes,
+    smoothing modifies the cached copy and drops its fields. The steps
+    are kept per file until it changes or is dropped, a mesh evicted
+    from the cache is smoothed again when it is reloaded. Connections
+    are served one after the other, the kernels use all threads.
+
+    Counts and lengths are checked, a negative or absurdly large value
+    is an error rather than a request that never finishes.
+
+    In compact mode the meshes are cached as CompactMesh instead, with
+    16-bit positions and curvature and e_avg in half precision, so about
+    twice as many stay warm. A detect then rebuilds the adjacency and
+    runs all convolutions, its status line adds the feature band of the
+    error bound; budget, radius and ring tables need the full precision
+    cache.
+**/
+
+class DaemonDOG
+{
+public:
+
+  DaemonDOG();
+  ~DaemonDOG();
+
+  /// default number of Gaussian convolutions
+  void set_iterations(int _iters) { iters_ = _iters; }
+
+  /// bytes the cached meshes may take, the last used one is always kept
+  void set_budget(size_t _bytes) { budget_ = _bytes; }
+
+  /// weld all meshes, not only triangle soups
+  void set_weld_epsilon(float _eps) { weld_ = true; weld_epsilon_ = _eps; }
+
+  /// cache meshes loaded from now on as CompactMesh
+  void set_compact(bool _compact) { compact_ = _compact; }
+
+  /// listen on _socket and serve requests until shutdown, false on errors
+  bool serve(const char* _socket);
+
+  /// answer one request line into _reply
+  void execute(const std::string& _request, std::string& _reply);
+
+  /// send _request to the daemon at _socket, copy the answer to _os
+  static bool query(const char* _socket, const std::string& _request, std::ostream& _os);
+
+
+private:
+
+  struct Entry;
+
+  /// smoothing steps applied to the file of this size and time
+  struct Smoothing
+  {
+    time_t        mtime;
+    off_t         size;
+    unsigned int  steps;
+  };
+
+  DaemonDOG(const DaemonDOG&);
+  DaemonDOG& operator=(const DaemonDOG&);
+
+  /// cached mesh of _path, loaded if missing or changed on disk; 0 if
+  /// it cannot be read. It moves to the front of the LRU list.
+  Entry* lookup(const std::string& _path, bool& _loaded);
+
+  /// drop the least recently used meshes until the budget holds
+  void trim();
+
+  /// serve the requests of one connection
+  void serve_connection(int _fd);
+
+  std::list<Entry*>  cache_;   // most recently used first
+  std::map<std::string, Smoothing>  smoothing_;   // survives eviction
+  ScratchArena       scratch_;  // temporaries of all cached kernels
+  int                iters_;
+  size_t             budget_;
+  bool               weld_;
+  float              weld_epsilon_;
+  bool               compact_;
+  bool               stop_;
+};
+
+
+//=============================================================================
+#endif // DAEMON_DOG_HH defined
+//=============================================================================
@@ -0,0 +1,277 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS FeatureGrid - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "FeatureGrid.hh"
+#include <algorithm>
+#include <unordered_map>
+#include <float.h>
+#include <math.h>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+namespace {
+
+// orders vertices by descending response, ties by index
+struct Stronger
+{
+  explicit Stronger(const float* _dog) : dog(_dog) {}
+  bool operator()(unsigned int _a, unsigned int _b) const
+  { return dog[_a] > dog[_b] || (dog[_a] == dog[_b] && _a < _b); }
+  const float* dog;
+};
+
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+FeatureGrid::
+select(const float* _x, const float* _y, const float* _z, size_t _stride,
+       const float* _dog, const unsigned int* _candidates, size_t _n,
+       size_t _budget, unsigned int _resolution,
+       std::vector<unsigned int>& _features)
+{
+  _features.clear();
+  if (_n == 0 || _budget == 0) return;
+
+  if (_n <= _budget)
+  {
+    _features.assign(_candidates, _candidates + _n);
+    std::sort(_features.begin(), _features.end());
+    return;
+  }
+
+
+  // bounding box of the candidates
+  float  bb_min[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+  float  bb_max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+  for (size_t i=0; i<_n; ++i)
+  {
+    const size_t  o(_candidates[i] * _stride);
+    const float   p[3] = { _x[o], _y[o], _z[o] };
+    for (int k=0; k<3; ++k)
+    {
+      bb_min[k] = std::min(bb_min[k], p[k]);
+      bb_max[k] = std::max(bb_max[k], p[k]);
+    }
+  }
+
+  const unsigned int  res(_resolution ? _resolution
+                          : std::max(1u, (unsigned int)ceil(sqrt(double(_budget)))));
+  const float         extent(std::max(bb_max[0]-bb_min[0],
+                                      std::max(bb_max[1]-bb_min[1], bb_max[2]-bb_min[2])));
+  const float         scale(extent > 0.0f ? res / extent : 0.0f);
+
+
+  // one pass: the occupied cells get consecutive slots
+  std::unordered_map<unsigned long long, unsigned int>  slots;
+  std::vector<unsigned int>                             cell(_n), count;
+
+  for (size_t i=0; i<_n; ++i)
+  {
+    const size_t        o(_candidates[i] * _stride);
+    unsigned long long  key(0);
+    const float         p[3] = { _x[o], _y[o], _z[o] };
+    for (int k=0; k<3; ++k)
+      key = key * (res+1) + std::min(res, (unsigned int)((p[k] - bb_min[k]) * scale));
+
+    std::pair<std::unordered_map<unsigned long long, unsigned int>::iterator, bool>
+      ins(slots.insert(std::make_pair(key, (unsigned int)count.size())));
+    if (ins.second) count.push_back(0);
+    cell[i] = ins.first->second;
+    ++count[cell[i]];
+  }
+
+
+  // candidates grouped by cell
+  const size_t               n_cells(count.size());
+  std::vector<unsigned int>  offsets(n_cells+1, 0), members(_n);
+
+  for (size_t c=0; c<n_cells; ++c)
+    offsets[c+1] = offsets[c] + count[c];
+  for (size_t i=0; i<_n; ++i)
+    members[offsets[cell[i]] + --count[cell[i]]] = _candidates[i];
+
+
+  // smallest k per cell that reaches the budget
+  unsigned int  lo(1), hi(0);
+  for (size_t c=0; c<n_cells; ++c)
+    hi = std::max(hi, offsets[c+1] - offsets[c]);
+  while (lo < hi)
+  {
+    const unsigned int  k((lo + hi) / 2);
+    size_t              total(0);
+    for (size_t c=0; c<n_cells; ++c)
+      total += std::min(k, offsets[c+1] - offsets[c]);
+    if (total >= _budget) hi = k;
+    else                  lo = k + 1;
+  }
+
+
+  // the k strongest of each cell; the cells with k or more candidates
+  // hold the surplus over the budget in their k-th strongest vertex
+  const Stronger             stronger(_dog);
+  std::vector<unsigned int>  marginal;
+
+  for (size_t c=0; c<n_cells; ++c)
+  {
+    unsigned int* begin(&members[0] + offsets[c]);
+    unsigned int* end(&members[0] + offsets[c+1]);
+    if (unsigned(end - begin) >= lo)
+    {
+      std::nth_element(begin, begin + (lo-1), end, stronger);
+      end = begin + (lo-1);
+      marginal.push_back(*end);
+    }
+    _features.insert(_features.end(), begin, end);
+  }
+
+  const size_t  keep(_budget - _features.size());
+  if (marginal.size() > keep)
+    std::nth_element(marginal.begin(), marginal.begin() + keep, marginal.end(), stronger);
+  _features.insert(_features.end(), marginal.begin(), marginal.begin() + std::min(keep, marginal.size()));
+  std::sort(_features.begin(), _features.end());
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+FeatureGrid::
+suppress(const float* _x, const float* _y, const float* _z, size_t _stride,
+         const float* _dog, const float* _eavg, float _radius,
+         std::vector<unsigned int>& _features)
+{
+  const size_t  n(_features.size());
+  if (n < 2 || _radius <= 0.0f) return;
+
+
+  // cells as large as the largest radius, over the bounding box
+  float  x0(FLT_MAX),  y0(FLT_MAX),  z0(FLT_MAX);
+  float  x1(-FLT_MAX), y1(-FLT_MAX), z1(-FLT_MAX), h(0.0f);
+
+#pragma omp parallel for schedule(static) reduction(min:x0,y0,z0) reduction(max:x1,y1,z1,h)
+  for (long long i=0; i<(long long)n; ++i)
+  {
+    const size_t  o(_features[i] * _stride);
+    x0 = std::min(x0, _x[o]);  x1 = std::max(x1, _x[o]);
+    y0 = std::min(y0, _y[o]);  y1 = std::max(y1, _y[o]);
+    z0 = std::min(z0, _z[o]);  z1 = std::max(z1, _z[o]);
+    h  = std::max(h, _radius * _eavg[_features[i]]);
+  }
+  if (!(h > 0.0f)) return;
+
+  const float  bb_min[3] = { x0, y0, z0 }, bb_max[3] = { x1, y1, z1 };
+
+  unsigned long long  dim[3];
+  for (int k=0; k<3; ++k)
+    dim[k] = (unsigned long long)((bb_max[k] - bb_min[k]) / h) + 1;
+
+
+  // strongest first, each kept feature is linked into the list of its
+  // cell. This stays serial: whether a feature survives depends on every
+  // stronger one kept before it, and each one only tests the few kept
+  // features of 27 cells, so the pass costs little next to the detection.
+  // Deciding in parallel rounds gives the same result, but every round
+  // has to scan the undecided stronger features too, several times the
+  // work of this pass.
+  std::vector<unsigned int>                             order(_features), kept, next;
+  std::unordered_map<unsigned long long, unsigned int>  head;
+  const unsigned int                                    none(~0u);
+
+  std::sort(order.begin(), order.end(), Stronger(_dog));
+  kept.reserve(n);
+  next.reserve(n);
+
+  for (size_t i=0; i<n; ++i)
+  {
+    const unsigned int  v(order[i]);
+    const size_t        o(v * _stride);
+    const float         p[3] = { _x[o], _y[o], _z[o] };
+    long long           c[3];
+    bool                covered(false);
+
+    for (int k=0; k<3; ++k)
+      c[k] = (long long)((p[k] - bb_min[k]) / h);
+
+    for (int dx=-1; dx<=1 && !covered; ++dx)
+    for (int dy=-1; dy<=1 && !covered; ++dy)
+    for (int dz=-1; dz<=1 && !covered; ++dz)
+    {
+      const long long  x(c[0]+dx), y(c[1]+dy), z(c[2]+dz);
+      if (x < 0 || y < 0 || z < 0 ||
+          x >= (long long)dim[0] || y >= (long long)dim[1] || z >= (long long)dim[2])
+        continue;
+
+      std::unordered_map<unsigned long long, unsigned int>::const_iterator
+        it(head.find((x * dim[1] + y) * dim[2] + z));
+      for (unsigned int j = (it == head.end() ? none : it->second); j != none; j = next[j])
+      {
+        const size_t  ow(kept[j] * _stride);
+        const float   d[3] = { _x[ow]-p[0], _y[ow]-p[1], _z[ow]-p[2] };
+        const float   r(_radius * _eavg[kept[j]]);
+        if (d[0]*d[0] + d[1]*d[1] + d[2]*d[2] < r*r) { covered = true; break; }
+      }
+    }
+    if (covered) continue;
+
+    const unsigned long long  key((c[0] * dim[1] + c[1]) * dim[2] + c[2]);
+    std::pair<std::unordered_map<unsigned long long, unsigned int>::iterator, bool>
+      ins(head.insert(std::make_pair(key, (unsigned int)kept.size())));
+    next.push_back(ins.second ? none : ins.first->second);
+    ins.first->second = kept.size();
+    kept.push_back(v);
+  }
+
+
+  // the kept features in their input order
+  std::sort(kept.begin(), kept.end());
+  size_t m(0);
+  for (size_t i=0; i<n; ++i)
+    if (std::binary_search(kept.begin(), kept.end(), _features[i]))
+      _features[m++] = _features[i];
+  _features.resize(m);
+}
+
+
+//=============================================================================
@@ -0,0 +1,92 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS FeatureGrid
+//
+//=============================================================================
+
+
+#ifndef FEATURE_GRID_HH
+#define FEATURE_GRID_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include <vector>
+#include <stddef.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class FeatureGrid FeatureGrid.hh
+    Spatially uniform selection of feature points.
+
+    A global DoG threshold puts most features on a few strongly curved
+    parts of the surface. FeatureGrid buckets the candidate vertices into
+    a uniform grid over their bounding box and keeps the strongest DoG
+    values of each cell instead. The number k kept per cell is the
+    smallest one for which the cells together reach the budget, so cells
+    with fewer candidates leave their share to the others. Only the last
+    cells at exactly k give up features to meet the budget, the weakest
+    ones first.
+
+    suppress() thins out features that still cluster, within a radius in
+    units of the average edge length around the stronger one.
+**/
+
+class FeatureGrid
+{
+public:
+
+  /** at most _budget of the _n candidate vertices, spread over a grid
+      with _resolution cells along the longest side of their bounding
+      box (0 for sqrt(_budget), about one feature per cell on a surface).
+      Vertex v is at (_x[v*_stride], _y[v*_stride], _z[v*_stride]) and
+      has the response _dog[v]. _features is sorted by vertex. **/
+  static void select(const float* _x, const float* _y, const float* _z,
+                     size_t _stride, const float* _dog,
+                     const unsigned int* _candidates, size_t _n,
+                     size_t _budget, unsigned int _resolution,
+                     std::vector<unsigned int>& _features);
+
+  /** drop the features closer than _radius * _eavg[v] to a stronger
+      feature v, strongest first; the rest keep their order. The kept
+      features are found through a hashed grid with cells of the largest
+      radius, so each test only looks at the 27 cells around it. **/
+  static void suppress(const float* _x, const float* _y, const float* _z,
+                       size_t _stride, const float* _dog, const float* _eavg,
+                       float _radius, std::vector<unsigned int>& _features);
+};
+
+
+//=============================================================================
+#endif // FEATURE_GRID_HH defined
+//=============================================================================
@@ -0,0 +1,355 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS HeatGeodesics - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "HeatGeodesics.hh"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+namespace {
+
+// orders vertex ids by one coordinate
+struct Along
+{
+  Along(const float* _points, int _axis) : points(_points), axis(_axis) {}
+  bool operator()(unsigned int _a, unsigned int _b) const
+  { return points[3*_a+axis] < points[3*_b+axis]; }
+  const float* points;
+  int          axis;
+};
+
+// true for the vertices without a neighbor marked in side
+struct Inner
+{
+  Inner(const MeshView& _view, const std::vector<unsigned char>& _side)
+    : view(_view), side(_side) {}
+  bool operator()(unsigned int _v) const
+  {
+    for (unsigned int i=view.ring_begin(_v); i<view.ring_end(_v); ++i)
+      if (side[view.neighbor(i)] == 1) return false;
+    return true;
+  }
+  const MeshView&                    view;
+  const std::vector<unsigned char>&  side;
+};
+
+// geometric nested dissection of ids[_b, _e): halves along the longest
+// side of the bounding box, the vertices of the second half next to the
+// first one are ordered after both halves
+void
+dissect(std::vector<unsigned int>& _ids, size_t _b, size_t _e, const float* _points,
+        const MeshView& _view, std::vector<unsigned char>& _side,
+        std::vector<unsigned int>& _order)
+{
+  if (_e - _b <= 64)
+  {
+    _order.insert(_order.end(), _ids.begin()+_b, _ids.begin()+_e);
+    return;
+  }
+
+  float bb_min[3] = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+  float bb_max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for (size_t i=_b; i<_e; ++i)
+    for (int k=0; k<3; ++k)
+    {
+      bb_min[k] = std::min(bb_min[k], _points[3*_ids[i]+k]);
+      bb_max[k] = std::max(bb_max[k], _points[3*_ids[i]+k]);
+    }
+  int axis(0);
+  for (int k=1; k<3; ++k)
+    if (bb_max[k]-bb_min[k] > bb_max[axis]-bb_min[axis]) axis = k;
+
+  const size_t m((_b + _e) / 2);
+  std::nth_element(_ids.begin()+_b, _ids.begin()+m, _ids.begin()+_e, Along(_points, axis));
+
+  for (size_t i=_b; i<m; ++i) _side[_ids[i]] = 1;
+  const size_t s(std::partition(_ids.begin()+m, _ids.begin()+_e, Inner(_view, _side)) - _ids.begin());
+  for (size_t i=_b; i<m; ++i) _side[_ids[i]] = 0;
+
+  dissect(_ids, _b, m, _points, _view, _side, _order);
+  dissect(_ids, m, s, _points, _view, _side, _order);
+  _order.insert(_order.end(), _ids.begin()+s, _ids.begin()+_e);
+}
+
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+HeatGeodesics::
+HeatGeodesics()
+{
+}
+
+
+void
+HeatGeodesics::
+clear()
+{
+  heat_.clear();
+  poisson_.clear();
+  std::vector<float>().swap(points_);
+  std::vector<unsigned int>().swap(faces_);
+  std::vector<float>().swap(gradients_);
+  std::vector<float>().swap(cotangents_);
+}
+
+
+size_t
+HeatGeodesics::
+bytes() const
+{
+  return heat_.bytes() + poisson_.bytes()
+    + (points_.capacity() + gradients_.capacity() + cotangents_.capacity()) * sizeof(float)
+    + faces_.capacity() * sizeof(unsigned int);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+HeatGeodesics::
+build(MeshView& _view, float _time_factor)
+{
+  const size_t  nv(_view.n_vertices()), nf(_view.n_faces());
+
+  clear();
+  if (!nv) return false;
+
+  const MeshView::Field_id  needed[] = { MeshView::EWEIGHT, MeshView::VWEIGHT };
+  _view.require(needed, 2);
+  const MeshView::Field&    eweight(_view.field(MeshView::EWEIGHT));
+  const MeshView::Field&    vweight(_view.field(MeshView::VWEIGHT));
+
+
+  // positions, mean edge length and time step
+  points_.resize(3*nv);
+  for (size_t v=0; v<nv; ++v)
+    _view.point(v, &points_[3*v]);
+
+  double  h(0.0);
+  size_t  n_half(0);
+  for (size_t v=0; v<nv; ++v)
+    for (unsigned int i=_view.ring_begin(v); i<_view.ring_end(v); ++i)
+    {
+      const float* p = &points_[3*v];
+      const float* q = &points_[3*_view.neighbor(i)];
+      h += sqrt((p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) + (p[2]-q[2])*(p[2]-q[2]));
+      ++n_half;
+    }
+  h = n_half ? h / n_half : 1.0;
+  const double  t(_time_factor * h * h);
+
+
+  // both matrices on the pattern of the 1-rings, diagonal first:
+  // L_ij = -(cot a + cot b) / 2, M_ii = a third of the incident areas;
+  // L has the constants as null space, the Poisson matrix gets a small
+  // multiple of M that the final shift makes up for
+  std::vector<unsigned int>  offsets(nv+1), columns;
+  std::vector<double>        heat, poisson;
+
+  columns.reserve(nv + _view.ring_end(nv-1));
+  offsets[0] = 0;
+  for (size_t v=0; v<nv; ++v)
+  {
+    const double  m(_view.valence(v) && vweight[v] > 0.0f && vweight[v] < FLT_MAX
+                    ? 0.5 / vweight[v] : h*h);
+    const size_t  d(columns.size());
+    double        l(0.0);
+
+    columns.push_back(v);
+    heat.push_back(0.0);
+    poisson.push_back(0.0);
+    for (unsigned int i=_view.ring_begin(v); i<_view.ring_end(v); ++i)
+    {
+      const double w(0.5 * eweight[_view.ring_edge(i)]);
+      columns.push_back(_view.neighbor(i));
+      heat.push_back(-t * w);
+      poisson.push_back(-w);
+      l += w;
+    }
+    heat[d]    = m + t * l;
+    poisson[d] = l + 1e-8 * m / (h*h);
+    offsets[v+1] = columns.size();
+  }
+
+
+  // faces: hat function gradients (N x e_i) / 2A and corner cotangents
+  faces_.resize(3*nf);
+  gradients_.assign(9*nf, 0.0f);
+  cotangents_.assign(3*nf, 0.0f);
+  for (size_t f=0; f<nf; ++f)
+  {
+    const unsigned int*  t3(_view.face(f));
+    float                e[3][3], n[3];
+    for (int i=0; i<3; ++i)
+    {
+      faces_[3*f+i] = t3[i];
+      for (int k=0; k<3; ++k)    // edge opposite corner i
+        e[i][k] = points_[3*t3[(i+2)%3]+k] - points_[3*t3[(i+1)%3]+k];
+    }
+    n[0] = e[2][1]*e[0][2] - e[2][2]*e[0][1];
+    n[1] = e[2][2]*e[0][0] - e[2][0]*e[0][2];
+    n[2] = e[2][0]*e[0][1] - e[2][1]*e[0][0];
+    const float a2(sqrtf(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]));   // twice the area
+    if (!(a2 > 0.0f)) continue;
+    for (int k=0; k<3; ++k) n[k] /= a2;
+
+    for (int i=0; i<3; ++i)
+    {
+      float* g = &gradients_[9*f+3*i];
+      g[0] = (n[1]*e[i][2] - n[2]*e[i][1]) / a2;
+      g[1] = (n[2]*e[i][0] - n[0]*e[i][2]) / a2;
+      g[2] = (n[0]*e[i][1] - n[1]*e[i][0]) / a2;
+
+      // angle at corner i between -e[i+2] and e[i+1]
+      const float* u = e[(i+1)%3];
+      const float* w = e[(i+2)%3];
+      cotangents_[3*f+i] = -(u[0]*w[0] + u[1]*w[1] + u[2]*w[2]) / a2;
+    }
+  }
+
+
+  // one ordering for both, the factorizations side by side
+  std::vector<unsigned int>   ids(nv), order;
+  std::vector<unsigned char>  side(nv, 0);
+  for (size_t v=0; v<nv; ++v) ids[v] = v;
+  order.reserve(nv);
+  dissect(ids, 0, nv, &points_[0], _view, side, order);
+
+  bool ok_heat(false), ok_poisson(false);
+#pragma omp parallel sections
+  {
+#pragma omp section
+    ok_heat = heat_.factor(nv, &offsets[0], &columns[0], &heat[0], order);
+#pragma omp section
+    ok_poisson = poisson_.factor(nv, &offsets[0], &columns[0], &poisson[0], order);
+  }
+
+  if (!ok_heat || !ok_poisson)
+  {
+    clear();
+    return false;
+  }
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+HeatGeodesics::
+distances(const unsigned int* _sources, size_t _n, float* _dist) const
+{
+  const size_t         nv(n_vertices()), nf(faces_.size()/3);
+  std::vector<double>  u(nv, 0.0), div(nv, 0.0), work(nv);
+
+  if (!nv) return;
+
+
+  // heat from the sources
+  for (size_t i=0; i<_n; ++i)
+    u[_sources[i]] = 1.0;
+  heat_.solve(&u[0], &work[0]);
+
+
+  // divergence of the normalized negative gradient: half the cotangent
+  // weighted products with the edges leaving each corner
+  for (size_t f=0; f<nf; ++f)
+  {
+    const unsigned int*  t3 = &faces_[3*f];
+    const float*         g  = &gradients_[9*f];
+    double               x[3] = { 0.0, 0.0, 0.0 };
+
+    for (int i=0; i<3; ++i)
+      for (int k=0; k<3; ++k)
+        x[k] -= u[t3[i]] * g[3*i+k];
+
+    const double len(sqrt(x[0]*x[0] + x[1]*x[1] + x[2]*x[2]));
+    if (!(len > 0.0)) continue;
+
+    for (int i=0; i<3; ++i)
+    {
+      const unsigned int  j(t3[(i+1)%3]), k(t3[(i+2)%3]);
+      const float*        p(&points_[3*t3[i]]);
+      const float*        pj(&points_[3*j]);
+      const float*        pk(&points_[3*k]);
+      double              ej(0.0), ek(0.0);
+      for (int c=0; c<3; ++c)
+      {
+        ej += (pj[c] - p[c]) * x[c];
+        ek += (pk[c] - p[c]) * x[c];
+      }
+      // the edge to j is opposite corner k and the other way round
+      div[t3[i]] += 0.5 * (cotangents_[3*f+(i+2)%3] * ej + cotangents_[3*f+(i+1)%3] * ek) / len;
+    }
+  }
+
+
+  // L phi = -div X, shifted to start at 0
+  for (size_t v=0; v<nv; ++v)
+    div[v] = -div[v];
+  poisson_.solve(&div[0], &work[0]);
+
+  double lowest(DBL_MAX);
+  for (size_t v=0; v<nv; ++v)
+    lowest = std::min(lowest, div[v]);
+  for (size_t v=0; v<nv; ++v)
+    _dist[v] = div[v] - lowest;
+}
+
+
+void
+HeatGeodesics::
+distance_rows(const unsigned int* _sources, size_t _n, float* _dist) const
+{
+  const long long n(_n);
+
+#pragma omp parallel for schedule(dynamic)
+  for (long long i=0; i<n; ++i)
+    distances(_sources + i, 1, _dist + i * n_vertices());
+}
+
+
+//=============================================================================
@@ -0,0 +1,110 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS HeatGeodesics
+//
+//=============================================================================
+
+
+#ifndef HEAT_GEODESICS_HH
+#define HEAT_GEODESICS_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include "MeshView.hh"
+#include "SparseLDL.hh"
+#include <vector>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class HeatGeodesics HeatGeodesics.hh
+    Geodesic distances by the heat method (Crane, Weischedel, Wardetzky,
+    "Geodesics in Heat", 2013).
+
+    Heat diffuses from the sources for a short time t, (M + t L) u = d,
+    the normalized negative gradient X = -grad u / |grad u| per face
+    points away from them, and the distance solves the Poisson equation
+    L phi = -div X. L is the cotangent stiffness matrix from the EWEIGHT
+    of a MeshView, M the lumped mass from its VWEIGHT, t the squared
+    mean edge length.
+
+    build() factors both systems once, in a nested dissection order of
+    the vertices, so each query costs two back-substitutions and two
+    passes over the faces. Queries only read the factors and can run on
+    several threads at once.
+**/
+
+class HeatGeodesics
+{
+public:
+
+  HeatGeodesics();
+
+  /** factor the heat and Poisson systems of the current positions of
+      _view, time step _time_factor times the squared mean edge length;
+      false if a factorization failed **/
+  bool build(MeshView& _view, float _time_factor = 1.0f);
+
+  void clear();
+
+  bool empty() const { return points_.empty(); }
+
+  size_t n_vertices() const { return points_.size() / 3; }
+
+  /// distance to the nearest of the _n sources for all vertices
+  void distances(const unsigned int* _sources, size_t _n, float* _dist) const;
+
+  /// distances from each of the _n sources, n_vertices() values per
+  /// source, the sources in parallel
+  void distance_rows(const unsigned int* _sources, size_t _n, float* _dist) const;
+
+  /// memory of the factors and the face data
+  size_t bytes() const;
+
+  /// entries of both factors
+  size_t n_entries() const { return heat_.n_entries() + poisson_.n_entries(); }
+
+
+private:
+
+  SparseLDL                  heat_, poisson_;
+  std::vector<float>         points_;     // xyz per vertex
+  std::vector<unsigned int>  faces_;      // three vertices per face
+  std::vector<float>         gradients_;  // of the hat functions, 9 per face
+  std::vector<float>         cotangents_; // of the corner angles, 3 per face
+};
+
+
+//=============================================================================
+#endif // HEAT_GEODESICS_HH defined
+//=============================================================================
@@ -0,0 +1,360 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS HugePageArena - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "HugePageArena.hh"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+namespace {
+
+/// a large block, kind tells where it came from
+struct Block
+{
+  enum Kind { ALIGNED, MAPPED, HUGETLB };
+
+  size_t  size;
+  Kind    kind;
+  size_t  huge;  // bytes on huge pages, of the last sample for MAPPED
+};
+
+/// state of the arena
+struct Arena
+{
+  typedef std::multimap<size_t, std::pair<char*, Block> > Pool;
+
+  std::mutex                mutex;
+  std::map<char*, Block>    blocks;
+  Pool                      pool;     // released blocks kept for reuse
+  HugePageArena::Mode       mode;
+  size_t                    live, peak;
+  size_t                    released, released_huge;  // as last sampled
+  size_t                    pooled, pool_limit, reused;
+
+  Arena() : mode(HugePageArena::HUGE_TRANSPARENT), live(0), peak(0),
+            released(0), released_huge(0), pooled(0), pool_limit(256 << 20),
+            reused(0) {}
+};
+
+Arena& arena()
+{
+  static Arena a;
+  return a;
+}
+
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+// set Block::huge of the MAPPED blocks from the AnonHugePages lines of
+// their mappings in /proc/self/smaps (unchanged where that file does not
+// exist); a mapping holding several blocks is split by their sizes
+static void sample_smaps(std::map<char*, Block>& _blocks)
+{
+  std::ifstream                     smaps("/proc/self/smaps");
+  std::string                       line, key;
+  std::map<char*, Block>::iterator  first(_blocks.end()), last(_blocks.end()), b;
+  size_t                            span(0);
+
+  while (std::getline(smaps, line))
+  {
+    uintptr_t begin, end;
+    char      dash;
+    std::istringstream in(line);
+
+    if (line.find(':') == std::string::npos || line.find('-') < line.find(':'))
+    {
+      // mapping header "begin-end perms ..."
+      in >> std::hex >> begin >> dash >> end;
+      first = _blocks.lower_bound((char*)begin);
+      last  = _blocks.lower_bound((char*)end);
+      span  = 0;
+      for (b=first; b!=last; ++b)
+        if (b->second.kind == Block::MAPPED)
+          span += b->second.size;
+    }
+    else if (span)
+    {
+      size_t kb;
+      in >> key >> kb;
+      if (key == "AnonHugePages:")
+        for (b=first; b!=last; ++b)
+          if (b->second.kind == Block::MAPPED)
+            b->second.huge = std::min(b->second.size,
+                                      size_t(double(kb << 10) * b->second.size / span));
+    }
+  }
+}
+
+
+/// give a block back to the system
+static void unmap(char* _data, const Block& _block)
+{
+  if (_block.kind == Block::ALIGNED)
+    free(_data);
+  else
+    munmap(_data, _block.size);
+}
+
+
+/// unmap the pooled blocks until at most _keep bytes are left, the
+/// largest first
+static void drain(Arena& _a, size_t _keep)
+{
+  while (_a.pooled > _keep)
+  {
+    Arena::Pool::iterator p(--_a.pool.end());
+    unmap(p->second.first, p->second.second);
+    _a.pooled -= p->first;
+    _a.pool.erase(p);
+  }
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+HugePageArena::
+set_mode(Mode _mode)
+{
+  std::lock_guard<std::mutex> lock(arena().mutex);
+  if (_mode != arena().mode)
+    drain(arena(), 0);
+  arena().mode = _mode;
+}
+
+
+void
+HugePageArena::
+set_pool_limit(size_t _bytes)
+{
+  std::lock_guard<std::mutex> lock(arena().mutex);
+  arena().pool_limit = _bytes;
+  drain(arena(), _bytes);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void*
+HugePageArena::
+allocate(size_t _bytes)
+{
+  Arena&  a(arena());
+  void*   data(0);
+
+  // small arrays are not worth a mapping
+  if (_bytes < huge_page / 2)
+  {
+    if (posix_memalign(&data, 4096, _bytes ? _bytes : 1) != 0)
+      return 0;
+    return data;
+  }
+
+  const size_t  size((_bytes + huge_page - 1) & ~(huge_page - 1));
+  Block         block = { size, Block::ALIGNED, 0 };
+  Mode          mode;
+  {
+    std::lock_guard<std::mutex> lock(a.mutex);
+    mode = a.mode;
+
+    // a pooled block of the size, or up to a quarter larger
+    Arena::Pool::iterator p(a.pool.lower_bound(size));
+    if (p != a.pool.end() && p->first <= size + size/4)
+    {
+      data  = p->second.first;
+      block = p->second.second;
+      a.pooled -= p->first;
+      a.pool.erase(p);
+      ++a.reused;
+
+      a.blocks[(char*)data] = block;
+      a.live += block.size;
+      if (a.live > a.peak) a.peak = a.live;
+      return data;
+    }
+  }
+
+
+#ifdef MAP_HUGETLB
+  if (mode == HUGE_EXPLICIT)
+  {
+    data = mmap(0, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data == MAP_FAILED)
+      data = 0;
+    else
+    {
+      block.kind = Block::HUGETLB;
+      block.huge = size;
+    }
+  }
+#endif
+
+  // over-allocate by a huge page and trim to a 2MB boundary
+  if (!data && mode != HUGE_OFF)
+  {
+    char* raw = (char*)mmap(0, size + huge_page, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw != MAP_FAILED)
+    {
+      char*   aligned = (char*)(((uintptr_t)raw + huge_page - 1) & ~(uintptr_t)(huge_page - 1));
+      size_t  head(aligned - raw), tail(huge_page - head);
+      if (head) munmap(raw, head);
+      if (tail) munmap(aligned + size, tail);
+#ifdef MADV_HUGEPAGE
+      madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+      data = aligned;
+      block.kind = Block::MAPPED;
+    }
+  }
+
+  if (!data && posix_memalign(&data, huge_page, size) != 0)
+    return 0;
+
+
+  std::lock_guard<std::mutex> lock(a.mutex);
+  a.blocks[(char*)data] = block;
+  a.live += size;
+  if (a.live > a.peak) a.peak = a.live;
+  return data;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+HugePageArena::
+release(void* _data, size_t _bytes)
+{
+  Arena& a(arena());
+
+  if (!_data) return;
+  if (_bytes < huge_page / 2)
+  {
+    free(_data);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(a.mutex);
+  std::map<char*, Block>::iterator b = a.blocks.find((char*)_data);
+  if (b == a.blocks.end()) return;
+
+  // no smaps lookup here, the block counts as last sampled
+  const Block block(b->second);
+  a.live          -= block.size;
+  a.released      += block.size;
+  a.released_huge += block.huge;
+  a.blocks.erase(b);
+
+  // kept with its pages for the next array of the size
+  if (a.pooled + block.size <= a.pool_limit)
+  {
+    a.pool.insert(std::make_pair(block.size, std::make_pair((char*)_data, block)));
+    a.pooled += block.size;
+  }
+  else
+    unmap((char*)_data, block);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+size_t
+HugePageArena::
+live_bytes()
+{
+  std::lock_guard<std::mutex> lock(arena().mutex);
+  return arena().live;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+HugePageArena::
+sample()
+{
+  std::lock_guard<std::mutex> lock(arena().mutex);
+  sample_smaps(arena().blocks);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+HugePageArena::
+report(std::ostream& _os)
+{
+  Arena&                  a(arena());
+  std::lock_guard<std::mutex> lock(a.mutex);
+  size_t                  huge(0);
+
+  sample_smaps(a.blocks);
+  for (std::map<char*, Block>::const_iterator b=a.blocks.begin(); b!=a.blocks.end(); ++b)
+    huge += b->second.huge;
+
+  const double mb = 1.0 / (1 << 20);
+  _os << "large arrays: " << a.live * mb << " MB live (" << huge * mb
+      << " MB on huge pages), " << a.released * mb << " MB released ("
+      << a.released_huge * mb << " MB on huge pages when sampled), peak "
+      << a.peak * mb << " MB, " << a.pooled * mb << " MB pooled, "
+      << a.reused << " blocks reused\n";
+}
+
+
+//=============================================================================
@@ -0,0 +1,103 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS HugePageArena
+//
+//=============================================================================
+
+
+#ifndef HUGE_PAGE_ARENA_HH
+#define HUGE_PAGE_ARENA_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include <iosfwd>
+#include <stddef.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class HugePageArena HugePageArena.hh
+    Process wide source of the large flat kernel arrays.
+
+    Blocks of at least one huge page are mapped on 2MB boundaries and
+    either taken from the explicit huge page pool (MAP_HUGETLB) or marked
+    for transparent huge pages (MADV_HUGEPAGE). Each step falls back to
+    the next one, the last one is plain aligned memory. Whether the kernel
+    really used huge pages is only known after the pages were touched, so
+    sample() and report() look up the backing of the live blocks in
+    /proc/self/smaps. A released block counts as last sampled, release()
+    does not read that file.
+
+    Released blocks stay mapped in a pool keyed by size, up to a limit,
+    and the next allocation takes one of its size, or up to a quarter
+    larger, back with its pages already faulted in. A pooled page keeps the
+    NUMA node of its first touch. Changing the mode empties the pool.
+**/
+
+class HugePageArena
+{
+public:
+
+  /// where large blocks come from
+  enum Mode { HUGE_OFF, HUGE_TRANSPARENT, HUGE_EXPLICIT };
+
+  /// size of a huge page, the alignment of large blocks
+  static const size_t huge_page = 2 << 20;
+
+  /// mode for future allocations, HUGE_TRANSPARENT by default
+  static void set_mode(Mode _mode);
+
+  /// bytes of released blocks kept for reuse, 256MB by default
+  static void set_pool_limit(size_t _bytes);
+
+  /// page aligned memory of _bytes, huge page backed if possible
+  static void* allocate(size_t _bytes);
+
+  /// give back a block of allocate(), to the pool if it has room
+  static void release(void* _data, size_t _bytes);
+
+  /// bytes currently allocated in large blocks
+  static size_t live_bytes();
+
+  /// look up the huge page backing of the live blocks, e.g. while a
+  /// run has its arrays touched; report() does it too
+  static void sample();
+
+  /// print how much of the memory was huge page backed
+  static void report(std::ostream& _os);
+};
+
+
+//=============================================================================
+#endif // HUGE_PAGE_ARENA_HH defined
+//=============================================================================
@@ -0,0 +1,119 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS MappedArray
+//
+//=============================================================================
+
+
+#ifndef MAPPED_ARRAY_HH
+#define MAPPED_ARRAY_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <sys/mman.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class MappedArray MappedArray.hh
+    Fixed size array of POD elements backed by an unlinked temporary file
+    (in $TMPDIR or /tmp). The kernel can write its pages back and drop
+    them under memory pressure, so arrays proportional to the mesh size do
+    not have to stay resident.
+**/
+
+template <class T>
+class MappedArray
+{
+public:
+
+  MappedArray() : data_(0), size_(0) {}
+  ~MappedArray() { release(); }
+
+  /// allocate _n zero initialized elements, previous contents are lost
+  bool resize(size_t _n)
+  {
+    release();
+    if (_n == 0) return true;
+
+    const char*  dir = getenv("TMPDIR");
+    std::string  name = std::string(dir ? dir : "/tmp") + "/meshdog.XXXXXX";
+    int          fd = mkstemp(&name[0]);
+
+    if (fd < 0) return false;
+    unlink(name.c_str());
+
+    void* p = MAP_FAILED;
+    if (ftruncate(fd, _n*sizeof(T)) == 0)
+      p = mmap(0, _n*sizeof(T), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (p == MAP_FAILED) return false;
+    data_ = static_cast<T*>(p);
+    size_ = _n;
+    return true;
+  }
+
+  /// unmap the array, the file disappears with the mapping
+  void release()
+  {
+    if (data_) munmap(data_, size_*sizeof(T));
+    data_ = 0;
+    size_ = 0;
+  }
+
+  size_t    size() const { return size_; }
+  T*        data()       { return data_; }
+  const T*  data() const { return data_; }
+
+  T&        operator[](size_t _i)       { return data_[_i]; }
+  const T&  operator[](size_t _i) const { return data_[_i]; }
+
+
+private:
+
+  MappedArray(const MappedArray&);
+  MappedArray& operator=(const MappedArray&);
+
+  T*      data_;
+  size_t  size_;
+};
+
+
+//=============================================================================
+#endif // MAPPED_ARRAY_HH defined
+//=============================================================================
+
@@ -0,0 +1,325 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS MeshCache - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "MeshCache.hh"
+#include <fstream>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+static const char      cache_magic[8] = { 'M','D','O','G','C','A','C','H' };
+static const uint32_t  cache_version  = 1;
+static const size_t    cache_align    = 64;
+
+
+// fixed size file header
+struct CacheHeader
+{
+  char      magic[8];
+  uint32_t  version;
+  uint32_t  n_sections;
+  uint64_t  key;
+  char      reserved[40];
+};
+
+
+// one entry of the section table following the header
+struct CacheEntry
+{
+  char      name[48];
+  uint64_t  offset;
+  uint64_t  size;
+};
+
+
+static size_t
+align_up(size_t _offset)
+{
+  return (_offset + cache_align - 1) / cache_align * cache_align;
+}
+
+
+static uint64_t
+fnv1a(uint64_t _hash, const void* _data, size_t _size)
+{
+  const unsigned char* p = static_cast<const unsigned char*>(_data);
+  for (size_t i=0; i<_size; ++i)
+    _hash = (_hash ^ p[i]) * 1099511628211ull;
+  return _hash;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+MeshCache::
+MeshCache()
+  : map_(0), map_size_(0)
+{
+}
+
+
+MeshCache::
+~MeshCache()
+{
+  close();
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshCache::
+source_key(const char* _filename, uint64_t& _key)
+{
+  struct stat  st;
+  int          fd = ::open(_filename, O_RDONLY);
+
+  if (fd < 0) return false;
+  if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+
+  // hashing a multi-GB scan on every open would eat the gain, so only
+  // 16 blocks spread over the file are hashed along with size and time
+  uint64_t  size(st.st_size), mtime(st.st_mtime);
+  uint64_t  hash(14695981039346656037ull);
+  char      block[4096];
+
+  hash = fnv1a(hash, &size,  sizeof(size));
+  hash = fnv1a(hash, &mtime, sizeof(mtime));
+  for (int i=0; i<16; ++i)
+  {
+    ssize_t n = pread(fd, block, sizeof(block), (off_t)(size / 16 * i));
+    if (n > 0) hash = fnv1a(hash, block, n);
+  }
+
+  ::close(fd);
+  _key = hash;
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+std::string
+MeshCache::
+cache_name(const char* _filename)
+{
+  return std::string(_filename) + ".mdc";
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshCache::
+open(const char* _filename, uint64_t _key)
+{
+  struct stat  st;
+  int          fd;
+
+  close();
+
+  if ((fd = ::open(_filename, O_RDONLY)) < 0)
+    return false;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CacheHeader))
+  {
+    ::close(fd);
+    return false;
+  }
+
+  map_size_ = st.st_size;
+  map_      = mmap(0, map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map_ == MAP_FAILED)
+  {
+    map_ = 0;
+    return false;
+  }
+
+
+  // validate header and section table
+  const char*         base   = static_cast<const char*>(map_);
+  const CacheHeader*  header = reinterpret_cast<const CacheHeader*>(base);
+
+  if (memcmp(header->magic, cache_magic, sizeof(cache_magic)) != 0 ||
+      header->version != cache_version ||
+      header->key != _key ||
+      sizeof(CacheHeader) + header->n_sections*sizeof(CacheEntry) > map_size_)
+  {
+    close();
+    return false;
+  }
+
+  const CacheEntry* entries = reinterpret_cast<const CacheEntry*>(base + sizeof(CacheHeader));
+  for (uint32_t i=0; i<header->n_sections; ++i)
+  {
+    if (entries[i].offset > map_size_ || entries[i].size > map_size_ - entries[i].offset)
+    {
+      close();
+      return false;
+    }
+
+    Section s;
+    s.name = std::string(entries[i].name, strnlen(entries[i].name, sizeof(entries[i].name)));
+    s.data = base + entries[i].offset;
+    s.size = entries[i].size;
+    sections_.push_back(s);
+  }
+
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshCache::
+close()
+{
+  if (map_)
+    munmap(map_, map_size_);
+
+  map_      = 0;
+  map_size_ = 0;
+  sections_.clear();
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+const void*
+MeshCache::
+section(const char* _name, size_t& _size) const
+{
+  for (size_t i=0; i<sections_.size(); ++i)
+    if (sections_[i].name == _name)
+    {
+      _size = sections_[i].size;
+      return sections_[i].data;
+    }
+
+  _size = 0;
+  return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshCache::
+add_section(const char* _name, const void* _data, size_t _size)
+{
+  Section s;
+  s.name = std::string(_name).substr(0, sizeof(CacheEntry().name)-1);
+  s.data = _data;
+  s.size = _size;
+  sections_.push_back(s);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshCache::
+write(const char* _filename, uint64_t _key) const
+{
+  // write to a temporary file so readers never map a partial cache
+  std::string    tmpname(std::string(_filename) + ".tmp");
+  std::ofstream  ofs(tmpname.c_str(), std::ios::binary | std::ios::trunc);
+  CacheHeader    header;
+  size_t         offset;
+  const char     zeros[cache_align] = { 0 };
+
+  if (!ofs) return false;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, cache_magic, sizeof(cache_magic));
+  header.version    = cache_version;
+  header.n_sections = sections_.size();
+  header.key        = _key;
+  ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+
+  // section table
+  offset = align_up(sizeof(CacheHeader) + sections_.size()*sizeof(CacheEntry));
+  for (size_t i=0; i<sections_.size(); ++i)
+  {
+    CacheEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.name, sections_[i].name.c_str(), sizeof(entry.name)-1);
+    entry.offset = offset;
+    entry.size   = sections_[i].size;
+    ofs.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+
+    offset = align_up(offset + sections_[i].size);
+  }
+
+
+  // section data, padded to the alignment
+  offset = sizeof(CacheHeader) + sections_.size()*sizeof(CacheEntry);
+  for (size_t i=0; i<sections_.size(); ++i)
+  {
+    ofs.write(zeros, align_up(offset) - offset);
+    ofs.write(static_cast<const char*>(sections_[i].data), sections_[i].size);
+    offset = align_up(offset) + sections_[i].size;
+  }
+
+  ofs.close();
+  if (!ofs || rename(tmpname.c_str(), _filename) != 0)
+  {
+    unlink(tmpname.c_str());
+    return false;
+  }
+  return true;
+}
+
+
+//=============================================================================
@@ -0,0 +1,121 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS MeshCache
+//
+//=============================================================================
+
+
+#ifndef MESH_CACHE_HH
+#define MESH_CACHE_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class MeshCache MeshCache.hh
+    Versioned binary cache of a loaded mesh and its derived fields.
+
+    The file holds a fixed header, a table of named sections and the
+    section data, each section aligned to 64 bytes. Reading a cache only
+    maps the file, the section pointers point directly into the mapping.
+    A cache is valid for one source file only, identified by source_key().
+**/
+
+class MeshCache
+{
+public:
+
+  MeshCache();
+  ~MeshCache();
+
+  /// fingerprint of a source file: size, modification time and sampled content
+  static bool source_key(const char* _filename, uint64_t& _key);
+
+  /// name of the cache file belonging to _filename
+  static std::string cache_name(const char* _filename);
+
+
+  /// map a cache file, fails if it is missing, corrupt or does not match _key
+  bool open(const char* _filename, uint64_t _key);
+
+  /// unmap the file and forget all sections
+  void close();
+
+  /// data of a section, 0 if missing or not holding _count elements of T
+  template <class T>
+  const T* section(const char* _name, size_t _count) const
+  {
+    size_t size;
+    const void* data = section(_name, size);
+    return (data && size == _count*sizeof(T)) ? static_cast<const T*>(data) : 0;
+  }
+
+  /// data and size in bytes of a section, 0 if missing
+  const void* section(const char* _name, size_t& _size) const;
+
+
+  /// register a section for write(), _data has to stay valid until then
+  void add_section(const char* _name, const void* _data, size_t _size);
+
+  /// write all registered sections
+  bool write(const char* _filename, uint64_t _key) const;
+
+
+private:
+
+  MeshCache(const MeshCache&);
+  MeshCache& operator=(const MeshCache&);
+
+  struct Section
+  {
+    std::string  name;
+    const void*  data;
+    size_t       size;
+  };
+
+  std::vector<Section>  sections_;
+  void*                 map_;
+  size_t                map_size_;
+};
+
+
+//=============================================================================
+#endif // MESH_CACHE_HH defined
+//=============================================================================
+
@@ -0,0 +1,386 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS MeshKernel - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "MeshKernel.hh"
+#include "FeatureGrid.hh"
+#include "ScratchArena.hh"
+#include <algorithm>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+MeshKernel::
+MeshKernel()
+  : xyz_(0), stride_(3), n_vertices_(0), scratch_(0)
+{
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshKernel::
+set_mesh(const float* _points, size_t _n_vertices,
+         const unsigned int* _faces, size_t _n_faces)
+{
+  points_.assign(_points, _points + 3*_n_vertices);
+  xyz_        = points_.empty() ? 0 : &points_[0];
+  stride_     = 3;
+  n_vertices_ = _n_vertices;
+  rings_.clear();
+  build_adjacency(_faces, _n_faces, 3);
+}
+
+
+void
+MeshKernel::
+attach(const float* _points, size_t _n_vertices, size_t _stride,
+       const unsigned int* _faces, size_t _n_faces, size_t _face_stride)
+{
+  Field().swap(points_);
+  xyz_        = _points;
+  stride_     = _stride;
+  n_vertices_ = _n_vertices;
+  rings_.clear();
+  build_adjacency(_faces, _n_faces, _face_stride);
+}
+
+
+void
+MeshKernel::
+build_adjacency(const unsigned int* _faces, size_t _n_faces, size_t _face_stride)
+{
+  const size_t         nv = n_vertices_;
+  ScratchArena         own(0);
+  ScratchArena&        arena(scratch_ ? *scratch_ : own);
+  ScratchArena::Frame  frame(arena);
+
+  // count the corner-to-corner pairs, then fill and dedupe every ring
+  unsigned int* count = arena.allocate<unsigned int>(nv+1);
+  std::fill(count, count+nv+1, 0u);
+  for (size_t f=0; f<_n_faces; ++f)
+    for (int i=0; i<3; ++i)
+      count[_faces[f*_face_stride + i]+1] += 2;
+  for (size_t v=0; v<nv; ++v)
+    count[v+1] += count[v];
+
+  unsigned int* pairs = arena.allocate<unsigned int>(count[nv]);
+  unsigned int* fill  = arena.allocate<unsigned int>(nv);
+  std::copy(count, count+nv, fill);
+  for (size_t f=0; f<_n_faces; ++f)
+  {
+    const unsigned int* t = _faces + f*_face_stride;
+    for (int i=0; i<3; ++i)
+    {
+      pairs[fill[t[i]]++] = t[(i+1)%3];
+      pairs[fill[t[i]]++] = t[(i+2)%3];
+    }
+  }
+
+  offsets_.resize(nv+1);
+  neighbors_.clear();
+  neighbors_.reserve(count[nv]/2);
+  offsets_[0] = 0;
+  for (size_t v=0; v<nv; ++v)
+  {
+    unsigned int *b(pairs+count[v]), *e(pairs+count[v+1]);
+    std::sort(b, e);
+    neighbors_.insert(neighbors_.end(), b, std::unique(b, e));
+    offsets_[v+1] = neighbors_.size();
+  }
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshKernel::
+calc_uniform_mean_curvature(Field& _curv) const
+{
+  const long long n = n_vertices();
+  _curv.resize(n);
+
+#pragma omp parallel for schedule(static)
+  for (long long v=0; v<n; ++v)
+    _curv[v] = uniform_mean_curvature(v);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshKernel::
+calc_edge_average(Field& _eavg) const
+{
+  const long long n = n_vertices();
+  _eavg.resize(n);
+
+#pragma omp parallel for schedule(static)
+  for (long long v=0; v<n; ++v)
+    _eavg[v] = edge_average(v);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshKernel::
+gaussian_conv_step(const Field& _eavg,
+                   Field& _f, Field& _dog) const
+{
+  const long long n = n_vertices();
+  _dog.resize(n);
+
+  // first all differences, then the update, so every vertex sees the
+  // previous level of its neighbors (single points keep their value)
+#pragma omp parallel for schedule(static)
+  for (long long v=0; v<n; ++v)
+    _dog[v] = valence(v) ? gaussian_conv(v, &_f[0], _eavg[v]) - _f[v] : 0.0f;
+
+#pragma omp parallel for schedule(static)
+  for (long long v=0; v<n; ++v)
+    _f[v] += _dog[v];
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshKernel::
+detect_meshdog(int _iters, const Field& _eavg,
+               Field& _f, Field& _dog) const
+{
+  _dog.assign(n_vertices(), 0.0f);
+  if (rings_.empty())
+  {
+    for (int i=0; i<_iters; ++i)
+      gaussian_conv_step(_eavg, _f, _dog);
+    return;
+  }
+
+  const float scale(rings_.theta_scale(_iters));
+  for (int i=rings_.passes(_iters); i>0; --i)
+    wide_conv_step(_eavg, scale, _f, _dog);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshKernel::
+wide_conv_step(const Field& _eavg, float _theta_scale,
+               Field& _f, Field& _dog) const
+{
+  const long long n = n_vertices();
+  _dog.resize(n);
+
+  // as gaussian_conv_step(), over the rows of the table
+#pragma omp parallel for schedule(static)
+  for (long long v=0; v<n; ++v)
+  {
+    const float  theta = _theta_scale * 1.25992105f * _eavg[v];
+    float        f1(0), K(0), k;
+
+    for (unsigned int i=rings_.begin(v); i<rings_.end(v); ++i)
+    {
+      k = gaussian(rings_.distance(i), theta);
+      K  += k;
+      f1 += _f[rings_.neighbor(i)] * k;
+    }
+    _dog[v] = K > 0.0f ? f1 / K - _f[v] : 0.0f;
+  }
+
+#pragma omp parallel for schedule(static)
+  for (long long v=0; v<n; ++v)
+    _f[v] += _dog[v];
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshKernel::
+build_rings(unsigned int _k)
+{
+  if (!n_vertices_) return;
+  rings_.build_rings(&offsets_[0], &neighbors_[0], n_vertices_,
+                     xyz_, xyz_+1, xyz_+2, stride_, _k);
+}
+
+
+void
+MeshKernel::
+build_geodesic(const Field& _eavg, float _radius)
+{
+  if (!n_vertices_) return;
+  rings_.build_geodesic(&offsets_[0], &neighbors_[0], n_vertices_,
+                        xyz_, xyz_+1, xyz_+2, stride_, &_eavg[0], _radius);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshKernel::
+select_features(const Field& _dog, double _fraction,
+                std::vector<unsigned int>& _features) const
+{
+  const size_t         nv(n_vertices());
+  ScratchArena         own(0);
+  ScratchArena&        arena(scratch_ ? *scratch_ : own);
+  ScratchArena::Frame  frame(arena);
+
+  _features.clear();
+  if (nv == 0) return;
+
+  float* sorted = arena.allocate<float>(nv);
+  for (size_t v=0; v<nv; ++v)
+    sorted[v] = isnan(_dog[v]) ? 0.0f : _dog[v];
+
+  const size_t k = std::min(nv-1, (size_t)(nv * _fraction));
+  std::nth_element(sorted, sorted + k, sorted + nv);
+  const float threshold = sorted[k];
+
+  for (size_t v=0; v<nv; ++v)
+    if (valence(v) && _dog[v] >= threshold)
+      _features.push_back(v);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshKernel::
+select_uniform_features(const Field& _dog, size_t _budget, unsigned int _resolution,
+                        std::vector<unsigned int>& _features) const
+{
+  const size_t         nv(n_vertices());
+  ScratchArena         own(0);
+  ScratchArena&        arena(scratch_ ? *scratch_ : own);
+  ScratchArena::Frame  frame(arena);
+  unsigned int*        candidates = arena.allocate<unsigned int>(nv);
+  size_t               n(0);
+
+  for (size_t v=0; v<nv; ++v)
+    if (valence(v) && !isnan(_dog[v]))
+      candidates[n++] = v;
+
+  _features.clear();
+  if (n == 0) return;
+
+  FeatureGrid::select(xyz_, xyz_+1, xyz_+2, stride_, &_dog[0], candidates, n,
+                      _budget, _resolution, _features);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshKernel::
+suppress_features(const Field& _dog, const Field& _eavg, float _radius,
+                  std::vector<unsigned int>& _features) const
+{
+  FeatureGrid::suppress(xyz_, xyz_+1, xyz_+2, stride_, &_dog[0], &_eavg[0],
+                        _radius, _features);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshKernel::
+uniform_smooth(unsigned int _iters)
+{
+  const size_t n = n_vertices();
+
+  // never write to the caller's positions
+  if (points_.empty() && n)
+  {
+    points_.resize(3*n);
+    for (size_t v=0; v<n; ++v)
+      for (int k=0; k<3; ++k)
+        points_[3*v + k] = point(v)[k];
+    xyz_    = &points_[0];
+    stride_ = 3;
+  }
+
+  // the distances in the ring table change
+  rings_.clear();
+
+  for (unsigned int iter=0; iter<_iters; ++iter)
+    for (size_t v=0; v<n; ++v)
+    {
+      float c[3] = { 0, 0, 0 };
+
+      if (!valence(v)) continue;
+
+      for (unsigned int i=offsets_[v]; i<offsets_[v+1]; ++i)
+        for (int k=0; k<3; ++k)
+          c[k] += points_[3*neighbors_[i] + k];
+
+      for (int k=0; k<3; ++k)
+        points_[3*v + k] += (c[k] / valence(v) - points_[3*v + k]) / 2;
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+size_t
+MeshKernel::
+bytes() const
+{
+  return points_.capacity() * sizeof(float)
+    + (offsets_.capacity() + neighbors_.capacity()) * sizeof(unsigned int)
+    + rings_.bytes();
+}
+
+
+//=============================================================================
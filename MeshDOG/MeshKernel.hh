@@ -0,0 +1,275 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS MeshKernel
+//
+//=============================================================================
+
+
+#ifndef MESH_KERNEL_HH
+#define MESH_KERNEL_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include "Numa.hh"
+#include "RingTable.hh"
+#include <vector>
+#include <stddef.h>
+#include <math.h>
+
+
+//== FORWARD DECLARATIONS =====================================================
+
+
+class ScratchArena;
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class MeshKernel MeshKernel.hh
+    Flat-array versions of the MeshDOG kernels of QualityViewer.
+
+    Positions are stored as xyz triples, the 1-ring adjacency in
+    compressed row format with every ring sorted by vertex index, so the
+    results do not depend on how the triangles were ordered. This lets
+    the pipeline run on parts of a mesh without building an OpenMesh
+    copy of it. attach() reads the positions from the caller's array
+    instead of copying them.
+
+    All arrays are placed by first touch from the OpenMP threads, and
+    the kernels here use the matching static schedule.
+**/
+
+class MeshKernel
+{
+public:
+
+  /// per-vertex scalar field
+  typedef std::vector<float, FirstTouchAllocator<float> > Field;
+
+  /// adjacency array
+  typedef std::vector<unsigned int, FirstTouchAllocator<unsigned int> > Indices;
+
+  MeshKernel();
+
+  /// copy positions and build the adjacency from the triangles
+  void set_mesh(const float* _points, size_t _n_vertices,
+                const unsigned int* _faces, size_t _n_faces);
+
+  /** use _points in place, vertex v at _points + v*_stride, which has to
+      stay valid and unchanged; triangle f is at _faces + f*_face_stride.
+      Strides count floats and indices. **/
+  void attach(const float* _points, size_t _n_vertices, size_t _stride,
+              const unsigned int* _faces, size_t _n_faces, size_t _face_stride);
+
+  size_t n_vertices() const { return n_vertices_; }
+
+  unsigned int valence(size_t _v) const { return offsets_[_v+1] - offsets_[_v]; }
+
+  /// position of vertex _v
+  const float* point(size_t _v) const { return xyz_ + stride_*_v; }
+
+  /// 1-ring of _v: neighbor(i), i in [ring_begin(_v), ring_end(_v))
+  unsigned int ring_begin(size_t _v) const { return offsets_[_v]; }
+  unsigned int ring_end(size_t _v)   const { return offsets_[_v+1]; }
+  unsigned int neighbor(size_t _i)   const { return neighbors_[_i]; }
+
+  /// bytes of positions, adjacency and the ring table
+  size_t bytes() const;
+
+  /** draw the temporaries of set_mesh(), attach() and the feature
+      selection from _arena, which has to outlive the kernel and must not
+      be used by another thread meanwhile; 0 allocates them per call **/
+  void set_scratch(ScratchArena* _arena) { scratch_ = _arena; }
+
+
+  /** convolve over the vertices up to _k edges away, or within _radius
+      average edge lengths along the edges, instead of the 1-rings; the
+      table is built here and dropped by set_mesh(), attach(),
+      uniform_smooth() and clear_rings() **/
+  void build_rings(unsigned int _k);
+  void build_geodesic(const Field& _eavg, float _radius);
+  void clear_rings() { rings_.clear(); }
+  const RingTable& rings() const { return rings_; }
+
+
+  /// length of the uniform Laplacian of _v / 2, NaN for isolated vertices
+  float uniform_mean_curvature(size_t _v) const;
+
+  /// average length of the edges around _v, 0 for isolated vertices
+  float edge_average(size_t _v) const;
+
+  /// Gaussian weighted average of _f over the 1-ring of _v
+  float gaussian_conv(size_t _v, const float* _f, float _eavg) const;
+
+
+  /// length of the uniform Laplacian / 2, NaN for isolated vertices
+  void calc_uniform_mean_curvature(Field& _curv) const;
+
+  /// average length of the edges around each vertex
+  void calc_edge_average(Field& _eavg) const;
+
+  /** one Gaussian convolution of _f over the 1-rings (Jacobi update),
+      _dog receives the difference to the previous level **/
+  void gaussian_conv_step(const Field& _eavg,
+                          Field& _f, Field& _dog) const;
+
+  /// one convolution over the ring table with a Gaussian _theta_scale
+  /// times as wide as that of gaussian_conv_step()
+  void wide_conv_step(const Field& _eavg, float _theta_scale,
+                      Field& _f, Field& _dog) const;
+
+  /// _iters convolutions of _f, _dog holds the last difference; with a
+  /// ring table fewer wide ones of about the same total width
+  void detect_meshdog(int _iters, const Field& _eavg,
+                      Field& _f, Field& _dog) const;
+
+  /// vertices with the largest (1-_fraction) DoG values, single points
+  /// excepted
+  void select_features(const Field& _dog, double _fraction,
+                       std::vector<unsigned int>& _features) const;
+
+  /// at most _budget features spread evenly over the surface, the
+  /// strongest DoG values of each cell of a uniform grid; see FeatureGrid
+  void select_uniform_features(const Field& _dog, size_t _budget,
+                               unsigned int _resolution,
+                               std::vector<unsigned int>& _features) const;
+
+  /// drop features within _radius average edge lengths of a stronger
+  /// one; see FeatureGrid
+  void suppress_features(const Field& _dog, const Field& _eavg, float _radius,
+                         std::vector<unsigned int>& _features) const;
+
+  /// uniform Laplacian smoothing, in place vertex by vertex; attached
+  /// positions are copied first
+  void uniform_smooth(unsigned int _iters);
+
+  /// Gaussian k(||vivj||) of the MeshDOG paper
+  static float gaussian(float _edge_length, float _theta);
+
+
+protected:
+
+  // xyz_ may point into points_
+  MeshKernel(const MeshKernel&);
+  MeshKernel& operator=(const MeshKernel&);
+
+  /// CSR rings of the triangles, _face_stride indices apart
+  void build_adjacency(const unsigned int* _faces, size_t _n_faces, size_t _face_stride);
+
+  Field         points_;      // own copy, empty when attached
+  const float*  xyz_;         // the positions used
+  size_t        stride_;      // floats from vertex to vertex
+  size_t        n_vertices_;
+  Indices       offsets_;     // n_vertices+1
+  Indices       neighbors_;   // sorted per vertex
+  RingTable     rings_;       // wide neighborhoods, empty for 1-rings
+  ScratchArena* scratch_;     // temporaries, 0 for none
+};
+
+
+//== INLINE IMPLEMENTATION ====================================================
+
+
+inline float
+MeshKernel::
+uniform_mean_curvature(size_t _v) const
+{
+  float lx(0), ly(0), lz(0), counter(0);
+
+  for (unsigned int i=offsets_[_v]; i<offsets_[_v+1]; ++i)
+  {
+    const float* q = point(neighbors_[i]);
+    lx += q[0];  ly += q[1];  lz += q[2];
+    counter++;
+  }
+
+  // get Lu(v), like QualityViewer this is NaN for isolated vertices
+  const float* p = point(_v);
+  lx = lx / counter - p[0];
+  ly = ly / counter - p[1];
+  lz = lz / counter - p[2];
+  return sqrtf(lx*lx + ly*ly + lz*lz) / 2;
+}
+
+
+inline float
+MeshKernel::
+edge_average(size_t _v) const
+{
+  const float*  p = point(_v);
+  float         eavg(0);
+
+  if (offsets_[_v] == offsets_[_v+1]) return 0.0f;
+
+  for (unsigned int i=offsets_[_v]; i<offsets_[_v+1]; ++i)
+  {
+    const float* q = point(neighbors_[i]);
+    eavg += sqrtf((p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) + (p[2]-q[2])*(p[2]-q[2]));
+  }
+  return eavg / (offsets_[_v+1] - offsets_[_v]);
+}
+
+
+inline float
+MeshKernel::
+gaussian_conv(size_t _v, const float* _f, float _eavg) const
+{
+  const float*  p = point(_v);
+  const float   theta = 1.25992105f * _eavg;  // 2^(1/3) * e_avg
+  float         f1(0), K(0), k;
+
+  for (unsigned int i=offsets_[_v]; i<offsets_[_v+1]; ++i)
+  {
+    const unsigned int  w = neighbors_[i];
+    const float*        q = point(w);
+    k = gaussian(sqrtf((p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) + (p[2]-q[2])*(p[2]-q[2])), theta);
+    K  += k;
+    f1 += _f[w] * k;
+  }
+  return f1 / K;
+}
+
+
+inline float
+MeshKernel::
+gaussian(float _edge_length, float _theta)
+{
+  return expf(-_edge_length*_edge_length / (2*_theta*_theta))
+    / (_theta * sqrtf(2 * M_PI));
+}
+
+
+//=============================================================================
+#endif // MESH_KERNEL_HH defined
+//=============================================================================
+
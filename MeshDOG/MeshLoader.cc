@@ -0,0 +1,1174 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS MeshLoader - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "MeshLoader.hh"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+
+//== PARSING HELPERS ==========================================================
+
+
+// number of chunks a body of _size bytes is split into
+static int
+n_chunks(size_t _size)
+{
+  size_t n = 1;
+#ifdef _OPENMP
+  n = 4 * omp_get_max_threads();
+#endif
+  // chunks below 64KB are not worth the bookkeeping
+  return (int)std::max<size_t>(1, std::min<size_t>(n, _size / 65536));
+}
+
+
+// cut [_begin,_end) into _n chunks, every chunk starts at a line start
+static void
+split_lines(const char* _begin, const char* _end, int _n,
+            std::vector<const char*>& _cuts)
+{
+  _cuts.resize(_n+1);
+  _cuts[0]  = _begin;
+  _cuts[_n] = _end;
+
+  for (int i=1; i<_n; ++i)
+  {
+    const char* p = std::max(_begin + (_end - _begin) / _n * i, _cuts[i-1]);
+    while (p < _end && p > _begin && p[-1] != '\n') ++p;
+    _cuts[i] = p;
+  }
+}
+
+
+static inline const char*
+skip_space(const char* _p, const char* _end)
+{
+  while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\r')) ++_p;
+  return _p;
+}
+
+
+static inline const char*
+next_line(const char* _p, const char* _end)
+{
+  const char* nl = static_cast<const char*>(memchr(_p, '\n', _end - _p));
+  return nl ? nl+1 : _end;
+}
+
+
+// decimal float as written by common exporters, 0 on failure
+static inline const char*
+parse_float(const char* _p, const char* _end, float& _v)
+{
+  static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                  1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                  1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+  double  m(0.0);
+  int     e(0), digits(0);
+  bool    neg(false);
+
+  _p = skip_space(_p, _end);
+  if (_p < _end && (*_p == '-' || *_p == '+')) neg = (*_p++ == '-');
+
+  for (; _p < _end && *_p >= '0' && *_p <= '9'; ++_p, ++digits)
+    m = 10.0*m + (*_p - '0');
+
+  if (_p < _end && *_p == '.')
+    for (++_p; _p < _end && *_p >= '0' && *_p <= '9'; ++_p, ++digits, --e)
+      m = 10.0*m + (*_p - '0');
+
+  if (!digits) return 0;
+
+  if (_p < _end && (*_p == 'e' || *_p == 'E'))
+  {
+    int   x(0);
+    bool  eneg(false);
+
+    if (++_p < _end && (*_p == '-' || *_p == '+')) eneg = (*_p++ == '-');
+    for (; _p < _end && *_p >= '0' && *_p <= '9'; ++_p)
+      x = std::min(10*x + (*_p - '0'), 1000);
+    e += eneg ? -x : x;
+  }
+
+  if      (e == 0)               {}
+  else if (e > 0 && e <= 22)     m *= pow10[e];
+  else if (e < 0 && e >= -22)    m /= pow10[-e];
+  else                           m *= pow(10.0, e);
+
+  _v = (float)(neg ? -m : m);
+  return _p;
+}
+
+
+// signed decimal integer, 0 on failure
+static inline const char*
+parse_int(const char* _p, const char* _end, long long& _v)
+{
+  bool neg(false);
+
+  _p = skip_space(_p, _end);
+  if (_p < _end && (*_p == '-' || *_p == '+')) neg = (*_p++ == '-');
+  if (_p >= _end || *_p < '0' || *_p > '9') return 0;
+
+  for (_v = 0; _p < _end && *_p >= '0' && *_p <= '9'; ++_p)
+    _v = 10*_v + (*_p - '0');
+  if (neg) _v = -_v;
+  return _p;
+}
+
+
+static bool
+host_little_endian()
+{
+  const uint16_t one(1);
+  return *reinterpret_cast<const unsigned char*>(&one) == 1;
+}
+
+
+//== PLY DESCRIPTION ==========================================================
+
+
+struct PlyProperty
+{
+  std::string  name;
+  char         type;        // 'i'nt, 'u'nsigned, 'f'loat
+  int          size;        // bytes of a scalar / of a list entry
+  bool         list;
+  int          count_size;  // bytes of the list length
+};
+
+
+struct PlyElement
+{
+  std::string               name;
+  size_t                    count;
+  std::vector<PlyProperty>  props;
+  bool                      has_list;
+  size_t                    stride;  // binary size if !has_list
+};
+
+
+static bool
+ply_type(const std::string& _s, char& _type, int& _size)
+{
+  if      (_s == "char"   || _s == "int8")    { _type = 'i'; _size = 1; }
+  else if (_s == "uchar"  || _s == "uint8")   { _type = 'u'; _size = 1; }
+  else if (_s == "short"  || _s == "int16")   { _type = 'i'; _size = 2; }
+  else if (_s == "ushort" || _s == "uint16")  { _type = 'u'; _size = 2; }
+  else if (_s == "int"    || _s == "int32")   { _type = 'i'; _size = 4; }
+  else if (_s == "uint"   || _s == "uint32")  { _type = 'u'; _size = 4; }
+  else if (_s == "float"  || _s == "float32") { _type = 'f'; _size = 4; }
+  else if (_s == "double" || _s == "float64") { _type = 'f'; _size = 8; }
+  else return false;
+  return true;
+}
+
+
+// little endian binary scalar as double
+static inline double
+ply_scalar(const char* _p, char _type, int _size)
+{
+  switch (_size)
+  {
+    case 1:
+      return (_type == 'i') ? double(*reinterpret_cast<const int8_t*>(_p))
+                            : double(*reinterpret_cast<const uint8_t*>(_p));
+    case 2:
+    {
+      uint16_t v; memcpy(&v, _p, 2);
+      return (_type == 'i') ? double(int16_t(v)) : double(v);
+    }
+    case 4:
+    {
+      uint32_t v; memcpy(&v, _p, 4);
+      if (_type == 'f') { float f; memcpy(&f, &v, 4); return f; }
+      return (_type == 'i') ? double(int32_t(v)) : double(v);
+    }
+    default:
+    {
+      double d; memcpy(&d, _p, 8);
+      return d;
+    }
+  }
+}
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+MeshLoader::
+MeshLoader()
+  : map_(0), map_size_(0), soup_(false), n_vertices_(0), points_(0)
+{
+}
+
+
+MeshLoader::
+~MeshLoader()
+{
+  clear();
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshLoader::
+can_read(const char* _filename)
+{
+  std::string ext(_filename);
+  size_t      dot = ext.rfind('.');
+
+  if (dot == std::string::npos) return false;
+  ext = ext.substr(dot+1);
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+  return (ext == "ply" || ext == "obj" || ext == "stl");
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshLoader::
+clear()
+{
+  if (map_)
+    munmap(map_, map_size_);
+
+  map_        = 0;
+  map_size_   = 0;
+  soup_       = false;
+  n_vertices_ = 0;
+  points_     = 0;
+  std::vector<float>().swap(point_buffer_);
+  std::vector<unsigned int>().swap(faces_);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshLoader::
+read(const char* _filename)
+{
+  struct stat  st;
+  int          fd;
+  bool         ok;
+
+  clear();
+
+  if (!can_read(_filename) || (fd = ::open(_filename, O_RDONLY)) < 0)
+    return false;
+  if (fstat(fd, &st) != 0 || st.st_size == 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  map_size_ = st.st_size;
+  map_      = mmap(0, map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map_ == MAP_FAILED)
+  {
+    map_ = 0;
+    return false;
+  }
+  madvise(map_, map_size_, MADV_SEQUENTIAL);
+
+  const char* begin = static_cast<const char*>(map_);
+  const char* end   = begin + map_size_;
+  std::string ext(_filename);
+  ext = ext.substr(ext.rfind('.')+1);
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+  if      (ext == "ply")  ok = read_ply(begin, end);
+  else if (ext == "obj")  ok = read_obj(begin, end);
+  else                    ok = read_stl(begin, end);
+  if (!ok)
+    clear();
+
+  return ok;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshLoader::
+read_ply(const char* _begin, const char* _end)
+{
+  // ---- header ----
+  std::vector<PlyElement>  elements;
+  std::string              format;
+  const char*              p = _begin;
+  const char*              body = 0;
+
+  while (p < _end && !body)
+  {
+    const char*         eol = next_line(p, _end);
+    std::istringstream  line(std::string(p, eol));
+    std::string         word;
+
+    line >> word;
+    if (p == _begin && word != "ply") return false;
+
+    if (word == "format")
+      line >> format;
+
+    else if (word == "element")
+    {
+      PlyElement e;
+      line >> e.name >> e.count;
+      e.has_list = false;
+      e.stride   = 0;
+      elements.push_back(e);
+    }
+
+    else if (word == "property" && !elements.empty())
+    {
+      PlyElement&  e = elements.back();
+      PlyProperty  prop;
+      std::string  type;
+
+      line >> type;
+      prop.list = (type == "list");
+      prop.count_size = 0;
+      if (prop.list)
+      {
+        char count_type;
+        line >> type;
+        if (!ply_type(type, count_type, prop.count_size)) return false;
+        line >> type;
+        e.has_list = true;
+      }
+      if (!ply_type(type, prop.type, prop.size)) return false;
+      line >> prop.name;
+
+      e.stride += prop.size;
+      e.props.push_back(prop);
+    }
+
+    else if (word == "end_header")
+      body = eol;
+
+    p = eol;
+  }
+
+  if (!body) return false;
+
+
+  // locate vertex positions and face indices
+  int  vertex_elem(-1), face_elem(-1), ix(-1), iy(-1), iz(-1), ilist(-1);
+
+  for (size_t i=0; i<elements.size(); ++i)
+  {
+    const PlyElement& e = elements[i];
+    if (e.name == "vertex" && !e.has_list)
+    {
+      vertex_elem = i;
+      for (size_t j=0; j<e.props.size(); ++j)
+      {
+        if (e.props[j].name == "x") ix = j;
+        if (e.props[j].name == "y") iy = j;
+        if (e.props[j].name == "z") iz = j;
+      }
+    }
+    else if (e.name == "face")
+    {
+      face_elem = i;
+      for (size_t j=0; j<e.props.size(); ++j)
+        if (e.props[j].list && (e.props[j].name == "vertex_indices" ||
+                                e.props[j].name == "vertex_index"))
+          ilist = j;
+    }
+  }
+
+  if (vertex_elem < 0 || ix < 0 || iy < 0 || iz < 0)
+    return false;
+  if (face_elem >= 0 && ilist < 0)
+    return false;
+
+  const PlyElement&  velem(elements[vertex_elem]);
+  const size_t       nv(velem.count);
+  const size_t       nf(face_elem >= 0 ? elements[face_elem].count : 0);
+  bool               error(false);
+
+  n_vertices_ = nv;
+
+
+  // ---- ASCII body ----
+  if (format == "ascii")
+  {
+    std::vector<const char*>  cuts;
+    const int                 n = n_chunks(_end - body);
+
+    split_lines(body, _end, n, cuts);
+
+
+    // line numbers of the chunk starts
+    std::vector<size_t> first_line(n+1, 0);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int c=0; c<n; ++c)
+    {
+      size_t lines = 0;
+      for (const char* q = cuts[c]; q < cuts[c+1]; q = next_line(q, cuts[c+1]))
+        ++lines;
+      first_line[c+1] = lines;
+    }
+    for (int c=0; c<n; ++c)
+      first_line[c+1] += first_line[c];
+
+
+    // line ranges of the elements
+    size_t vbegin(0), fbegin(0), line(0);
+    for (size_t i=0; i<elements.size(); ++i)
+    {
+      if ((int)i == vertex_elem) vbegin = line;
+      if ((int)i == face_elem)   fbegin = line;
+      line += elements[i].count;
+    }
+    if (first_line[n] < line) return false;
+
+    const size_t ncoords = std::max(ix, std::max(iy, iz)) + 1;
+    point_buffer_.resize(3*nv);
+    std::vector< std::vector<unsigned int> > chunk_faces(n);
+
+#pragma omp parallel for schedule(dynamic) reduction(||:error)
+    for (int c=0; c<n; ++c)
+    {
+      std::vector<unsigned int>&  faces = chunk_faces[c];
+      std::vector<float>          coords(ncoords);
+      std::vector<unsigned int>   poly;
+      size_t                      l(first_line[c]);
+      const char*                 cend(cuts[c+1]);
+
+      for (const char* q = cuts[c]; q < cend && !error; q = next_line(q, cend), ++l)
+      {
+        if (l >= vbegin && l < vbegin+nv)
+        {
+          const char* t = q;
+          for (size_t j=0; j<ncoords && t; ++j)
+            t = parse_float(t, cend, coords[j]);
+          if (!t) { error = true; break; }
+
+          float* pt = &point_buffer_[3*(l-vbegin)];
+          pt[0] = coords[ix];
+          pt[1] = coords[iy];
+          pt[2] = coords[iz];
+        }
+
+        else if (face_elem >= 0 && l >= fbegin && l < fbegin+nf)
+        {
+          const char*  t = q;
+          long long    k, idx;
+          float        skip;
+
+          for (int j=0; j<ilist && t; ++j)
+            t = parse_float(t, cend, skip);
+          if (!t || !(t = parse_int(t, cend, k)) || k < 3) { error = true; break; }
+
+          poly.clear();
+          for (long long j=0; j<k; ++j)
+          {
+            if (!(t = parse_int(t, cend, idx)) || idx < 0 || idx >= (long long)nv)
+            { error = true; break; }
+            poly.push_back((unsigned int)idx);
+          }
+          if (error) break;
+
+          for (size_t j=2; j<poly.size(); ++j)
+          {
+            faces.push_back(poly[0]);
+            faces.push_back(poly[j-1]);
+            faces.push_back(poly[j]);
+          }
+        }
+      }
+    }
+    if (error) return false;
+
+
+    size_t total(0);
+    for (int c=0; c<n; ++c) total += chunk_faces[c].size();
+    faces_.reserve(total);
+    for (int c=0; c<n; ++c)
+    {
+      faces_.insert(faces_.end(), chunk_faces[c].begin(), chunk_faces[c].end());
+      std::vector<unsigned int>().swap(chunk_faces[c]);
+    }
+
+    points_ = nv ? &point_buffer_[0] : 0;
+    return true;
+  }
+
+
+  // ---- binary body ----
+  if (format != "binary_little_endian" || !host_little_endian())
+    return false;
+
+  const char*  vdata(0);
+  const char*  fdata(0);
+
+  p = body;
+  for (size_t i=0; i<elements.size() && p; ++i)
+  {
+    const PlyElement& e = elements[i];
+
+    if (!e.has_list)
+    {
+      if ((size_t)(_end - p) < e.count * e.stride) return false;
+      if ((int)i == vertex_elem) vdata = p;
+      p += e.count * e.stride;
+    }
+
+    else if ((int)i == face_elem)
+    {
+      fdata = p;
+      if ((int)i == (int)elements.size()-1) break;  // no need to find its end
+
+      // skip the variable sized face records
+      for (size_t f=0; f<e.count && p; ++f)
+        for (size_t j=0; j<e.props.size() && p; ++j)
+        {
+          const PlyProperty& prop = e.props[j];
+          size_t bytes = prop.size;
+          if (prop.list)
+          {
+            if (_end - p < prop.count_size) { p = 0; break; }
+            bytes = prop.count_size + prop.size *
+                    (size_t)ply_scalar(p, 'u', prop.count_size);
+          }
+          p = ((size_t)(_end - p) < bytes) ? 0 : p + bytes;
+        }
+    }
+
+    else
+      return false;  // list elements we do not know the layout of
+  }
+  if (!vdata || (face_elem >= 0 && !fdata)) return false;
+
+
+  // vertices: use the mapping directly if it holds packed float positions
+  std::vector<size_t> offsets(velem.props.size()+1, 0);
+  for (size_t j=0; j<velem.props.size(); ++j)
+    offsets[j+1] = offsets[j] + velem.props[j].size;
+
+  const PlyProperty &px(velem.props[ix]), &py(velem.props[iy]), &pz(velem.props[iz]);
+
+  if (velem.stride == 12 && ix == 0 && iy == 1 && iz == 2 &&
+      px.type == 'f' && px.size == 4 && py.type == 'f' && py.size == 4 &&
+      pz.type == 'f' && pz.size == 4 &&
+      reinterpret_cast<uintptr_t>(vdata) % sizeof(float) == 0)
+  {
+    points_ = reinterpret_cast<const float*>(vdata);
+  }
+  else
+  {
+    point_buffer_.resize(3*nv);
+
+#pragma omp parallel for
+    for (long long v=0; v<(long long)nv; ++v)
+    {
+      const char* rec = vdata + v * velem.stride;
+      point_buffer_[3*v  ] = (float)ply_scalar(rec + offsets[ix], px.type, px.size);
+      point_buffer_[3*v+1] = (float)ply_scalar(rec + offsets[iy], py.type, py.size);
+      point_buffer_[3*v+2] = (float)ply_scalar(rec + offsets[iz], pz.type, pz.size);
+    }
+    points_ = nv ? &point_buffer_[0] : 0;
+  }
+
+  if (face_elem < 0)
+    return true;
+
+
+  // faces: triangles-only files have fixed size records and are read in
+  // parallel, everything else sequentially
+  const PlyElement&   felem(elements[face_elem]);
+  const PlyProperty&  plist(felem.props[ilist]);
+  const size_t        tri_stride(plist.count_size + 3*plist.size);
+
+  if (felem.props.size() == 1 && (size_t)(_end - fdata) >= nf * tri_stride)
+  {
+    bool not_triangles(false);
+    faces_.resize(3*nf);
+
+#pragma omp parallel for reduction(||:error, not_triangles)
+    for (long long f=0; f<(long long)nf; ++f)
+    {
+      const char* rec = fdata + f * tri_stride;
+      if (ply_scalar(rec, 'u', plist.count_size) != 3)
+      {
+        not_triangles = true;
+        continue;
+      }
+      for (int j=0; j<3; ++j)
+      {
+        double idx = ply_scalar(rec + plist.count_size + j*plist.size, plist.type, plist.size);
+        if (idx < 0 || idx >= nv) error = true;
+        faces_[3*f+j] = (unsigned int)idx;
+      }
+    }
+
+    if (error) return false;
+    if (!not_triangles) return true;
+    faces_.clear();
+  }
+
+  std::vector<unsigned int> poly;
+  faces_.reserve(3*nf);
+  p = fdata;
+  for (size_t f=0; f<nf; ++f)
+    for (size_t j=0; j<felem.props.size(); ++j)
+    {
+      const PlyProperty& prop = felem.props[j];
+
+      if (!prop.list)
+      {
+        if ((size_t)(_end - p) < (size_t)prop.size) return false;
+        p += prop.size;
+        continue;
+      }
+
+      if (_end - p < prop.count_size) return false;
+      size_t k = (size_t)ply_scalar(p, 'u', prop.count_size);
+      p += prop.count_size;
+      if ((size_t)(_end - p) < k * prop.size) return false;
+
+      poly.clear();
+      for (size_t i=0; i<k; ++i, p+=prop.size)
+        poly.push_back((unsigned int)ply_scalar(p, prop.type, prop.size));
+
+      if ((int)j != ilist) continue;
+      for (size_t i=0; i<k; ++i)
+        if (poly[i] >= nv) return false;
+      for (size_t i=2; i<k; ++i)
+      {
+        faces_.push_back(poly[0]);
+        faces_.push_back(poly[i-1]);
+        faces_.push_back(poly[i]);
+      }
+    }
+
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshLoader::
+read_obj(const char* _begin, const char* _end)
+{
+  std::vector<const char*>  cuts;
+  const int                 n = n_chunks(_end - _begin);
+  bool                      error(false);
+
+  // per chunk: vertices, triangles and the positions of triangle indices
+  // that are relative to the chunk (negative OBJ indices)
+  std::vector< std::vector<float> >      chunk_points(n);
+  std::vector< std::vector<long long> >  chunk_faces(n);
+  std::vector< std::vector<size_t> >     chunk_relative(n);
+
+  split_lines(_begin, _end, n, cuts);
+
+#pragma omp parallel for schedule(dynamic) reduction(||:error)
+  for (int c=0; c<n; ++c)
+  {
+    std::vector<float>&      points   = chunk_points[c];
+    std::vector<long long>&  faces    = chunk_faces[c];
+    std::vector<size_t>&     relative = chunk_relative[c];
+    std::vector<long long>   poly;
+    std::vector<bool>        poly_relative;
+    const char*              cend(cuts[c+1]);
+
+    for (const char* q = cuts[c]; q < cend && !error; q = next_line(q, cend))
+    {
+      const char* t = skip_space(q, cend);
+      if (cend - t < 2 || (t[1] != ' ' && t[1] != '\t')) continue;
+
+      if (t[0] == 'v')
+      {
+        float x, y, z;
+        if (!(t = parse_float(t+1, cend, x)) ||
+            !(t = parse_float(t,   cend, y)) ||
+            !(t = parse_float(t,   cend, z)))
+        { error = true; break; }
+
+        points.push_back(x);
+        points.push_back(y);
+        points.push_back(z);
+      }
+
+      else if (t[0] == 'f')
+      {
+        const char*  eol = next_line(t, cend);
+        long long    idx;
+
+        poly.clear();
+        poly_relative.clear();
+        for (t = skip_space(t+1, eol); t < eol && *t != '\n'; t = skip_space(t, eol))
+        {
+          if (!(t = parse_int(t, eol, idx)) || idx == 0) { error = true; break; }
+
+          // OBJ indices are 1-based, negative ones count back from the
+          // last vertex read so far
+          if (idx > 0)
+          {
+            poly.push_back(idx - 1);
+            poly_relative.push_back(false);
+          }
+          else
+          {
+            poly.push_back((long long)(points.size()/3) + idx);
+            poly_relative.push_back(true);
+          }
+
+          // skip texture and normal indices
+          while (t < eol && *t != ' ' && *t != '\t' && *t != '\r' && *t != '\n') ++t;
+        }
+        if (error) break;
+        if (poly.size() < 3) continue;
+
+        for (size_t j=2; j<poly.size(); ++j)
+        {
+          const size_t corners[3] = { 0, j-1, j };
+          for (int i=0; i<3; ++i)
+          {
+            if (poly_relative[corners[i]]) relative.push_back(faces.size());
+            faces.push_back(poly[corners[i]]);
+          }
+        }
+      }
+    }
+  }
+  if (error) return false;
+
+
+  // offsets of the chunks in the global vertex and face arrays
+  std::vector<size_t> voffset(n+1, 0), foffset(n+1, 0);
+  for (int c=0; c<n; ++c)
+  {
+    voffset[c+1] = voffset[c] + chunk_points[c].size()/3;
+    foffset[c+1] = foffset[c] + chunk_faces[c].size();
+  }
+
+  n_vertices_ = voffset[n];
+  point_buffer_.resize(3*n_vertices_);
+  faces_.resize(foffset[n]);
+
+#pragma omp parallel for schedule(dynamic) reduction(||:error)
+  for (int c=0; c<n; ++c)
+  {
+    std::vector<long long>& faces = chunk_faces[c];
+
+    for (size_t i=0; i<chunk_relative[c].size(); ++i)
+      faces[chunk_relative[c][i]] += voffset[c];
+
+    for (size_t i=0; i<faces.size(); ++i)
+    {
+      if (faces[i] < 0 || faces[i] >= (long long)n_vertices_) error = true;
+      faces_[foffset[c]+i] = (unsigned int)faces[i];
+    }
+
+    std::copy(chunk_points[c].begin(), chunk_points[c].end(),
+              point_buffer_.begin() + 3*voffset[c]);
+  }
+  if (error) return false;
+
+  points_ = n_vertices_ ? &point_buffer_[0] : 0;
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshLoader::
+read_stl(const char* _begin, const char* _end)
+{
+  const size_t  size(_end - _begin);
+  size_t        n_triangles(0);
+
+  soup_ = true;
+
+  if (size >= 84)
+  {
+    uint32_t n;
+    memcpy(&n, _begin + 80, 4);
+    n_triangles = n;
+  }
+
+
+  // binary: 80 byte header, triangle count, 50 bytes per triangle
+  // (normal, three corners, attribute word)
+  if (size >= 84 && size == 84 + 50*n_triangles && host_little_endian())
+  {
+    point_buffer_.resize(9*n_triangles);
+
+#pragma omp parallel for
+    for (long long t=0; t<(long long)n_triangles; ++t)
+      memcpy(&point_buffer_[9*t], _begin + 84 + 50*t + 12, 9*sizeof(float));
+  }
+
+
+  // ASCII: every "vertex x y z" line is a corner, three make a facet
+  else
+  {
+    const char* t = skip_space(_begin, _end);
+    if (_end - t < 5 || strncmp(t, "solid", 5) != 0)
+      return false;
+
+    std::vector<const char*>           cuts;
+    const int                          n = n_chunks(size);
+    std::vector< std::vector<float> >  chunk_points(n);
+    bool                               error(false);
+
+    split_lines(_begin, _end, n, cuts);
+
+#pragma omp parallel for schedule(dynamic) reduction(||:error)
+    for (int c=0; c<n; ++c)
+    {
+      const char* cend(cuts[c+1]);
+      for (const char* q = cuts[c]; q < cend && !error; q = next_line(q, cend))
+      {
+        const char* t = skip_space(q, cend);
+        if (cend - t < 6 || strncmp(t, "vertex", 6) != 0) continue;
+
+        float x, y, z;
+        if (!(t = parse_float(t+6, cend, x)) ||
+            !(t = parse_float(t,   cend, y)) ||
+            !(t = parse_float(t,   cend, z)))
+        { error = true; break; }
+
+        chunk_points[c].push_back(x);
+        chunk_points[c].push_back(y);
+        chunk_points[c].push_back(z);
+      }
+    }
+    if (error) return false;
+
+    // chunks may split a facet, the corners stay in file order anyway
+    size_t total(0);
+    for (int c=0; c<n; ++c) total += chunk_points[c].size();
+    if (total % 9) return false;
+
+    n_triangles = total / 9;
+    point_buffer_.reserve(total);
+    for (int c=0; c<n; ++c)
+    {
+      point_buffer_.insert(point_buffer_.end(), chunk_points[c].begin(), chunk_points[c].end());
+      std::vector<float>().swap(chunk_points[c]);
+    }
+  }
+
+
+  n_vertices_ = 3*n_triangles;
+  points_     = n_vertices_ ? &point_buffer_[0] : 0;
+  faces_.resize(n_vertices_);
+  for (size_t i=0; i<n_vertices_; ++i)
+    faces_[i] = i;
+
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+// hash table entry: grid cell and the range of its points in sorted order
+struct WeldCell
+{
+  uint64_t  key;
+  size_t    begin, end;
+};
+
+
+static inline size_t
+cell_hash(uint64_t _key, size_t _mask)
+{
+  _key ^= _key >> 33;
+  _key *= 0xff51afd7ed558ccdull;
+  _key ^= _key >> 33;
+  return (size_t)_key & _mask;
+}
+
+
+void
+MeshLoader::
+weld(float _epsilon)
+{
+  typedef std::pair<uint64_t, unsigned int> KeyIndex;
+
+  const size_t  nv(n_vertices_);
+  const float*  pts(points_);
+  float         bbmin[3], bbmax[3], extent(0.0f), h;
+
+  if (nv == 0) return;
+
+
+  // bounding box
+  float  x0(FLT_MAX),  y0(FLT_MAX),  z0(FLT_MAX);
+  float  x1(-FLT_MAX), y1(-FLT_MAX), z1(-FLT_MAX);
+
+#pragma omp parallel for schedule(static) reduction(min:x0,y0,z0) reduction(max:x1,y1,z1)
+  for (long long i=0; i<(long long)nv; ++i)
+  {
+    x0 = std::min(x0, pts[3*i]);    x1 = std::max(x1, pts[3*i]);
+    y0 = std::min(y0, pts[3*i+1]);  y1 = std::max(y1, pts[3*i+1]);
+    z0 = std::min(z0, pts[3*i+2]);  z1 = std::max(z1, pts[3*i+2]);
+  }
+  bbmin[0] = x0;  bbmin[1] = y0;  bbmin[2] = z0;
+  bbmax[0] = x1;  bbmax[1] = y1;  bbmax[2] = z1;
+  for (int k=0; k<3; ++k)
+    extent = std::max(extent, bbmax[k] - bbmin[k]);
+
+  if (_epsilon <= 0.0f)
+    _epsilon = 1e-6f * sqrtf((bbmax[0]-bbmin[0])*(bbmax[0]-bbmin[0]) +
+                             (bbmax[1]-bbmin[1])*(bbmax[1]-bbmin[1]) +
+                             (bbmax[2]-bbmin[2])*(bbmax[2]-bbmin[2]));
+
+  // cells at least epsilon wide, so partners are in the 27 neighbor
+  // cells, and at most 2^21 of them per axis to fit a 64 bit key
+  h = std::max(std::max(_epsilon, extent / 2000000.0f), 1e-30f);
+  const float eps2 = _epsilon * _epsilon;
+
+
+  // cell key of every point, sorted in parallel blocks and merged
+  std::vector<KeyIndex> keys(nv);
+
+#pragma omp parallel for
+  for (long long i=0; i<(long long)nv; ++i)
+  {
+    uint64_t c[3];
+    for (int k=0; k<3; ++k)
+      c[k] = (uint64_t)((pts[3*i+k] - bbmin[k]) / h) + 1;
+    keys[i] = KeyIndex((c[0] << 42) | (c[1] << 21) | c[2], (unsigned int)i);
+  }
+
+  int n_blocks = n_chunks(nv * sizeof(KeyIndex));
+  std::vector<size_t> cuts(n_blocks+1);
+  for (int b=0; b<=n_blocks; ++b)
+    cuts[b] = nv / n_blocks * b;
+  cuts[n_blocks] = nv;
+
+#pragma omp parallel for
+  for (int b=0; b<n_blocks; ++b)
+    std::sort(keys.begin()+cuts[b], keys.begin()+cuts[b+1]);
+
+  for (int width=1; width<n_blocks; width*=2)
+  {
+#pragma omp parallel for
+    for (int b=0; b<n_blocks-width; b+=2*width)
+      std::inplace_merge(keys.begin()+cuts[b],
+                         keys.begin()+cuts[b+width],
+                         keys.begin()+cuts[std::min(b+2*width, n_blocks)]);
+  }
+
+
+  // occupied cells, collected per block and concatenated; a cell ends
+  // where the next one begins
+  std::vector< std::vector<WeldCell> >  block_cells(n_blocks);
+  std::vector<size_t>                   first_cell(n_blocks+1, 0);
+
+#pragma omp parallel for schedule(static)
+  for (int b=0; b<n_blocks; ++b)
+  {
+    for (size_t i=cuts[b]; i<cuts[b+1]; ++i)
+      if (i == 0 || keys[i].first != keys[i-1].first)
+      {
+        WeldCell cell = { keys[i].first, i, i };
+        block_cells[b].push_back(cell);
+      }
+    first_cell[b+1] = block_cells[b].size();
+  }
+  for (int b=0; b<n_blocks; ++b)
+    first_cell[b+1] += first_cell[b];
+
+  std::vector<WeldCell> cells(first_cell[n_blocks]);
+
+#pragma omp parallel for schedule(static)
+  for (int b=0; b<n_blocks; ++b)
+  {
+    std::copy(block_cells[b].begin(), block_cells[b].end(),
+              cells.begin() + first_cell[b]);
+    std::vector<WeldCell>().swap(block_cells[b]);
+  }
+
+
+  // hash table over the occupied cells, filled by all threads; a slot
+  // is claimed by swapping -1 for the cell index
+  size_t table_size(1);
+  while (table_size < 2*cells.size()) table_size *= 2;
+  const size_t mask(table_size-1);
+
+  std::vector< std::atomic<long long> > table(table_size);
+
+#pragma omp parallel for schedule(static)
+  for (long long s=0; s<(long long)table_size; ++s)
+    table[s].store(-1, std::memory_order_relaxed);
+
+#pragma omp parallel for schedule(static)
+  for (long long c=0; c<(long long)cells.size(); ++c)
+  {
+    cells[c].end = (c+1 < (long long)cells.size()) ? cells[c+1].begin : nv;
+
+    size_t     slot = cell_hash(cells[c].key, mask);
+    long long  empty(-1);
+    while (!table[slot].compare_exchange_strong(empty, c, std::memory_order_relaxed))
+    {
+      slot  = (slot+1) & mask;
+      empty = -1;
+    }
+  }
+
+
+  // every point is merged into the smallest index within epsilon
+  std::vector<unsigned int> rep(nv);
+
+#pragma omp parallel for schedule(dynamic, 4096)
+  for (long long s=0; s<(long long)nv; ++s)
+  {
+    const unsigned int  i = keys[s].second;
+    const float*        p = pts + 3*i;
+    const uint64_t      key = keys[s].first;
+    unsigned int        best = i;
+
+    for (int dx=-1; dx<=1; ++dx)
+      for (int dy=-1; dy<=1; ++dy)
+        for (int dz=-1; dz<=1; ++dz)
+        {
+          const uint64_t nkey = key + ((int64_t)dx << 42) + ((int64_t)dy << 21) + dz;
+          size_t     slot = cell_hash(nkey, mask);
+          long long  c;
+          while ((c = table[slot].load(std::memory_order_relaxed)) >= 0 &&
+                 cells[c].key != nkey)
+            slot = (slot+1) & mask;
+          if (c < 0) continue;
+
+          const WeldCell& cell = cells[c];
+          for (size_t t=cell.begin; t<cell.end; ++t)
+          {
+            const unsigned int  j = keys[t].second;
+            const float*        q = pts + 3*j;
+            if (j < best &&
+                (p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) +
+                (p[2]-q[2])*(p[2]-q[2]) <= eps2)
+              best = j;
+          }
+        }
+
+    rep[i] = best;
+  }
+  std::vector<KeyIndex>().swap(keys);
+  std::vector< std::atomic<long long> >().swap(table);
+
+
+  // resolve chains (rep[i] <= i) and number the surviving points
+  std::vector<unsigned int>  remap(nv);
+  size_t                     n_welded(0);
+
+  for (size_t i=0; i<nv; ++i)
+  {
+    rep[i]   = rep[rep[i]];
+    remap[i] = (rep[i] == i) ? n_welded++ : remap[rep[i]];
+  }
+
+  std::vector<float> welded(3*n_welded);
+
+#pragma omp parallel for
+  for (long long i=0; i<(long long)nv; ++i)
+    if (rep[i] == (unsigned int)i)
+      memcpy(&welded[3*remap[i]], pts + 3*i, 3*sizeof(float));
+
+
+  // remap the triangles, dropping those that collapsed
+  const size_t       nf(faces_.size() / 3);
+  std::vector<char>  keep(nf);
+
+#pragma omp parallel for
+  for (long long f=0; f<(long long)nf; ++f)
+  {
+    unsigned int* t = &faces_[3*f];
+    t[0] = remap[t[0]];
+    t[1] = remap[t[1]];
+    t[2] = remap[t[2]];
+    keep[f] = (t[0] != t[1] && t[1] != t[2] && t[2] != t[0]);
+  }
+
+  size_t n_kept(0);
+  for (size_t f=0; f<nf; ++f)
+    if (keep[f])
+    {
+      if (n_kept != f)
+        memcpy(&faces_[3*n_kept], &faces_[3*f], 3*sizeof(unsigned int));
+      ++n_kept;
+    }
+  faces_.resize(3*n_kept);
+
+
+  point_buffer_.swap(welded);
+  points_     = n_welded ? &point_buffer_[0] : 0;
+  n_vertices_ = n_welded;
+  soup_       = false;
+
+  std::cerr << "welded " << nv << " into " << n_welded << " vertices, dropped "
+            << nf - n_kept << " degenerate faces\n";
+}
+
+
+//=============================================================================
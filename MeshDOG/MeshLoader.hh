@@ -0,0 +1,119 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS MeshLoader
+//
+//=============================================================================
+
+
+#ifndef MESH_LOADER_HH
+#define MESH_LOADER_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class MeshLoader MeshLoader.hh
+    Parallel reader for triangle meshes in PLY, OBJ and STL format.
+
+    The file is memory mapped. ASCII bodies are split into chunks at line
+    boundaries which are parsed in parallel, binary PLY vertex blocks are
+    used in place when they hold nothing but float positions. Polygons are
+    triangulated as fans. Files the loader does not understand (big endian,
+    unusual elements) make read() fail so the caller can fall back to
+    OpenMesh. STL files are read as triangle soups, weld() merges their
+    coincident vertices before the connectivity is built.
+**/
+
+class MeshLoader
+{
+public:
+
+  MeshLoader();
+  ~MeshLoader();
+
+  /// true if the file extension is one read() understands
+  static bool can_read(const char* _filename);
+
+  /// parse a mesh file, previous data is released
+  bool read(const char* _filename);
+
+  /// release the mapping and all buffers
+  void clear();
+
+  /// true if the file is a triangle soup that has to be welded
+  bool is_soup() const { return soup_; }
+
+  /** merge vertices closer than _epsilon and drop the triangles that
+      degenerate, _epsilon <= 0 uses 1e-6 of the bounding box diagonal.
+      Vertices keep the order of their first occurrence. **/
+  void weld(float _epsilon);
+
+  size_t n_vertices() const { return n_vertices_; }
+  size_t n_faces()    const { return faces_.size() / 3; }
+
+  /// vertex positions, three floats per vertex (may point into the mapping)
+  const float* points() const { return points_; }
+
+  /// triangle vertex indices, three per face
+  const unsigned int* faces() const { return faces_.empty() ? 0 : &faces_[0]; }
+
+
+private:
+
+  MeshLoader(const MeshLoader&);
+  MeshLoader& operator=(const MeshLoader&);
+
+  bool read_ply(const char* _begin, const char* _end);
+  bool read_obj(const char* _begin, const char* _end);
+  bool read_stl(const char* _begin, const char* _end);
+
+  void*                      map_;
+  size_t                     map_size_;
+
+  bool                       soup_;
+  size_t                     n_vertices_;
+  const float*               points_;
+  std::vector<float>         point_buffer_;
+  std::vector<unsigned int>  faces_;
+};
+
+
+//=============================================================================
+#endif // MESH_LOADER_HH defined
+//=============================================================================
+
@@ -0,0 +1,1153 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS MeshView - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "MeshView.hh"
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <float.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+// vertices, edges or faces per task of the kernel loops
+static const long long grain = 4096;
+
+
+
+MeshView::
+MeshView()
+  : clock_(0), dog_iters_(0), dog_level_(0), ring_k_(1), ring_radius_(0.0f),
+    dog_jacobi_(false), n_dog_channels_(1), dog_channel_(0)
+{
+  dog_channels_[0] = UNICURVATURE;
+  for (int i=0; i<N_FIELDS; ++i)
+  {
+    valid_[i]    = false;
+    revision_[i] = 0;
+    last_use_[i] = 0;
+  }
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshView::
+pull(const Mesh& _mesh)
+{
+  Mesh::ConstVertexIter           v_it, v_end(_mesh.vertices_end());
+  Mesh::ConstEdgeIter             e_it, e_end(_mesh.edges_end());
+  Mesh::ConstFaceIter             f_it, f_end(_mesh.faces_end());
+  Mesh::ConstVertexOHalfedgeIter  voh_it;
+  Mesh::ConstFaceVertexIter       fv_it;
+  Mesh::HalfedgeHandle            h0, h1;
+  Mesh::FaceHandle                fh;
+
+  pull_points(_mesh);
+
+
+  // 1-rings in circulator order
+  offsets_.resize(_mesh.n_vertices() + 1);
+  neighbors_.clear();
+  ring_edges_.clear();
+  ring_faces_.clear();
+  neighbors_.reserve(_mesh.n_halfedges());
+  ring_edges_.reserve(_mesh.n_halfedges());
+  ring_faces_.reserve(_mesh.n_halfedges());
+
+  offsets_[0] = 0;
+  for (v_it=_mesh.vertices_begin(); v_it!=v_end; ++v_it)
+  {
+    for (voh_it=_mesh.cvoh_iter(v_it); voh_it; ++voh_it)
+    {
+      fh = _mesh.face_handle(voh_it.handle());
+      neighbors_.push_back(_mesh.to_vertex_handle(voh_it.handle()).idx());
+      ring_edges_.push_back(_mesh.edge_handle(voh_it.handle()).idx());
+      ring_faces_.push_back(fh.is_valid() ? fh.idx() : no_face);
+    }
+    offsets_[v_it.handle().idx()+1] = neighbors_.size();
+  }
+
+
+  // edge end points and the vertices after them
+  edges_.resize(4 * _mesh.n_edges());
+  for (e_it=_mesh.edges_begin(); e_it!=e_end; ++e_it)
+  {
+    unsigned int* e = &edges_[4 * e_it.handle().idx()];
+    h0 = _mesh.halfedge_handle(e_it.handle(), 0);
+    h1 = _mesh.halfedge_handle(e_it.handle(), 1);
+    e[0] = _mesh.to_vertex_handle(h0).idx();
+    e[1] = _mesh.to_vertex_handle(h1).idx();
+    e[2] = _mesh.to_vertex_handle(_mesh.next_halfedge_handle(h0)).idx();
+    e[3] = _mesh.to_vertex_handle(_mesh.next_halfedge_handle(h1)).idx();
+  }
+
+  faces_.resize(3 * _mesh.n_faces());
+  for (f_it=_mesh.faces_begin(); f_it!=f_end; ++f_it)
+  {
+    unsigned int* f = &faces_[3 * f_it.handle().idx()];
+    fv_it = _mesh.cfv_iter(f_it);
+    f[0] = fv_it.handle().idx();  ++fv_it;
+    f[1] = fv_it.handle().idx();  ++fv_it;
+    f[2] = fv_it.handle().idx();
+  }
+
+
+  for (int i=0; i<N_FIELDS; ++i)
+    release(Field_id(i));
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshView::
+pull_points(const Mesh& _mesh)
+{
+  const long long n = _mesh.n_vertices();
+
+  x_.resize(n);  y_.resize(n);  z_.resize(n);
+  invalidate();
+
+#pragma omp parallel for schedule(static)
+  for (long long v=0; v<n; ++v)
+  {
+    const Mesh::Point& p = _mesh.point(Mesh::VertexHandle(v));
+    x_[v] = p[0];  y_[v] = p[1];  z_[v] = p[2];
+  }
+}
+
+
+void
+MeshView::
+push_points(Mesh& _mesh) const
+{
+  const long long n = n_vertices();
+
+#pragma omp parallel for schedule(static)
+  for (long long v=0; v<n; ++v)
+    _mesh.set_point(Mesh::VertexHandle(v), Mesh::Point(x_[v], y_[v], z_[v]));
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+MeshView::Field&
+MeshView::
+allocate(Field_id _id)
+{
+  fields_[_id].resize(_id == EWEIGHT ? n_edges() : _id == TSHAPE ? n_faces() :
+                      _id == DOG_CHANNEL_F || _id == DOG_CHANNEL_DOG ? dog_width() * n_vertices() :
+                      n_vertices());
+  return fields_[_id];
+}
+
+
+void
+MeshView::
+allocate_outputs(Field_id _id)
+{
+  switch (_id)
+  {
+    case VWEIGHT:
+    case EWEIGHT:
+      allocate(VWEIGHT);
+      allocate(EWEIGHT);
+      break;
+
+    case DOG_F:
+    case DOG_DOG:
+    case DOG_CHANNEL_F:
+    case DOG_CHANNEL_DOG:
+      if (dog_width() > 1)
+      {
+        allocate(DOG_CHANNEL_F);
+        allocate(DOG_CHANNEL_DOG);
+      }
+      allocate(DOG_F);
+      allocate(DOG_DOG);
+      break;
+
+    // inputs without a kernel
+    case GEODESIC:
+    case LUMINANCE:
+    case USER_FUNCTION:
+      break;
+
+    default:
+      allocate(_id);
+      break;
+  }
+}
+
+
+void
+MeshView::
+set_field(Field_id _id, const float* _data, size_t _n)
+{
+  fields_[_id].assign(_data, _data + _n);
+  validate(_id);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+const MeshView::Field&
+MeshView::
+require(Field_id _id)
+{
+  switch (_id)
+  {
+    case VWEIGHT:
+    case EWEIGHT:
+      if (!valid_[_id]) calc_weights();
+      break;
+
+    case CURVATURE:
+      if (!valid_[_id]) calc_mean_curvature();
+      break;
+
+    case UNICURVATURE:
+      if (!valid_[_id]) calc_uniform_mean_curvature();
+      break;
+
+    case GAUSSCURVATURE:
+      if (!valid_[_id]) calc_gauss_curvature();
+      break;
+
+    case TSHAPE:
+      if (!valid_[_id]) calc_triangle_quality();
+      break;
+
+    case EAVG:
+      if (!valid_[_id]) calc_edge_average();
+      break;
+
+    case DOG_F:
+    case DOG_DOG:
+    case DOG_CHANNEL_F:
+    case DOG_CHANNEL_DOG:
+      // the levels only go forward, start over for fewer
+      if (!dog_valid() || dog_level_ > dog_iters_)
+        init_meshdog();
+      if (dog_level_ < dog_iters_)
+        detect_meshdog(dog_iters_ - dog_level_);
+      break;
+
+    default:
+      break;
+  }
+
+  last_use_[_id] = tick();
+  return fields_[_id];
+}
+
+
+void
+MeshView::
+require(const Field_id* _ids, size_t _n)
+{
+  bool  need[N_FIELDS] = { false };
+  char  order[N_FIELDS];   // dependence objects of the fields
+
+  for (size_t i=0; i<_n; ++i)
+    mark_stale(_ids[i], need);
+
+  // size the outputs before the team, a kernel task would touch them
+  // from one thread
+  for (int i=0; i<N_FIELDS; ++i)
+    if (need[i])
+      allocate_outputs(Field_id(i));
+
+  // one task per stale kernel, after the tasks writing its inputs
+#pragma omp parallel
+#pragma omp single
+  {
+    if (need[VWEIGHT] || need[EWEIGHT])
+    {
+#pragma omp task default(shared) depend(out: order[VWEIGHT], order[EWEIGHT])
+      calc_weights();
+    }
+    if (need[CURVATURE])
+    {
+#pragma omp task default(shared) depend(in: order[VWEIGHT], order[EWEIGHT]) depend(out: order[CURVATURE])
+      calc_mean_curvature();
+    }
+    if (need[UNICURVATURE])
+    {
+#pragma omp task default(shared) depend(out: order[UNICURVATURE])
+      calc_uniform_mean_curvature();
+    }
+    if (need[GAUSSCURVATURE])
+    {
+#pragma omp task default(shared) depend(in: order[VWEIGHT]) depend(out: order[GAUSSCURVATURE])
+      calc_gauss_curvature();
+    }
+    if (need[TSHAPE])
+    {
+#pragma omp task default(shared) depend(out: order[TSHAPE])
+      calc_triangle_quality();
+    }
+    if (need[EAVG])
+    {
+#pragma omp task default(shared) depend(out: order[EAVG])
+      calc_edge_average();
+    }
+    if (need[DOG_F] || need[DOG_DOG] || need[DOG_CHANNEL_F] || need[DOG_CHANNEL_DOG])
+    {
+      // after any per-vertex field a channel may come from
+#pragma omp task default(shared) depend(in: order[VWEIGHT], order[CURVATURE], order[UNICURVATURE], \
+                                            order[GAUSSCURVATURE], order[EAVG])
+      require(DOG_DOG);
+    }
+  }
+
+  for (size_t i=0; i<_n; ++i)
+    last_use_[_ids[i]] = tick();
+}
+
+
+void
+MeshView::
+mark_stale(Field_id _id, bool* _need) const
+{
+  const bool stale = (_id == DOG_F || _id == DOG_DOG || _id == DOG_CHANNEL_F || _id == DOG_CHANNEL_DOG)
+    ? !dog_valid() || dog_level_ != dog_iters_
+    : !valid_[_id];
+
+  if (!stale || _need[_id]) return;
+  _need[_id] = true;
+
+  switch (_id)
+  {
+    case CURVATURE:
+      mark_stale(VWEIGHT, _need);
+      mark_stale(EWEIGHT, _need);
+      break;
+
+    case GAUSSCURVATURE:
+      mark_stale(VWEIGHT, _need);
+      break;
+
+    case DOG_F:
+    case DOG_DOG:
+    case DOG_CHANNEL_F:
+    case DOG_CHANNEL_DOG:
+      for (size_t i=0; i<n_dog_channels_; ++i)
+        mark_stale(dog_channels_[i], _need);
+      mark_stale(EAVG, _need);
+      break;
+
+    default:
+      break;
+  }
+}
+
+
+bool
+MeshView::
+dog_valid() const
+{
+  return valid_[DOG_F] && valid_[DOG_DOG] &&
+    (n_dog_channels_ == 1 || (valid_[DOG_CHANNEL_F] && valid_[DOG_CHANNEL_DOG]));
+}
+
+
+unsigned int
+MeshView::
+tick()
+{
+  unsigned int t;
+#pragma omp atomic capture
+  t = ++clock_;
+  return t;
+}
+
+
+void
+MeshView::
+invalidate()
+{
+  // the inputs do not depend on the positions
+  for (int i=0; i<N_FIELDS; ++i)
+    if (i != LUMINANCE && i != USER_FUNCTION)
+      valid_[i] = false;
+  dog_level_ = 0;
+  rings_.clear();
+}
+
+
+void
+MeshView::
+set_dog_iterations(int _iters)
+{
+  dog_iters_ = _iters;
+}
+
+
+void
+MeshView::
+set_dog_rings(unsigned int _k)
+{
+  if (_k == ring_k_ && ring_radius_ == 0.0f) return;
+  ring_k_      = std::max(1u, _k);
+  ring_radius_ = 0.0f;
+  rings_.clear();
+  valid_[DOG_F] = valid_[DOG_DOG] = false;
+}
+
+
+void
+MeshView::
+set_dog_geodesic(float _radius)
+{
+  if (_radius == ring_radius_) return;
+  ring_k_      = 1;
+  ring_radius_ = std::max(0.0f, _radius);
+  rings_.clear();
+  valid_[DOG_F] = valid_[DOG_DOG] = false;
+}
+
+
+void
+MeshView::
+set_dog_jacobi(bool _jacobi)
+{
+  if (_jacobi == dog_jacobi_) return;
+  dog_jacobi_ = _jacobi;
+  valid_[DOG_F] = valid_[DOG_DOG] = false;
+}
+
+
+void
+MeshView::
+set_dog_channels(const Field_id* _ids, size_t _n)
+{
+  // per-vertex fields only
+  size_t n(0);
+  for (size_t i=0; i<_n && n<max_dog_channels; ++i)
+    if (_ids[i] != EWEIGHT && _ids[i] != TSHAPE &&
+        (_ids[i] < DOG_F || _ids[i] > DOG_CHANNEL_DOG))
+      dog_channels_[n++] = _ids[i];
+  if (!n)
+    dog_channels_[n++] = UNICURVATURE;
+
+  n_dog_channels_ = n;
+  dog_channel_    = 0;
+  valid_[DOG_F] = valid_[DOG_DOG] = false;
+  release(DOG_CHANNEL_F);
+  release(DOG_CHANNEL_DOG);
+}
+
+
+void
+MeshView::
+set_dog_channel(size_t _ch)
+{
+  if (_ch >= n_dog_channels_ || _ch == dog_channel_) return;
+  dog_channel_ = _ch;
+
+  if (dog_valid())
+  {
+    show_dog_channel();
+    validate(DOG_F);
+    validate(DOG_DOG);
+  }
+  else
+    valid_[DOG_F] = valid_[DOG_DOG] = false;
+}
+
+
+void
+MeshView::
+trim(size_t _budget)
+{
+  size_t  total(field_bytes());
+  int     victim;
+
+  while (total > _budget)
+  {
+    // stale fields first, then the one required longest ago
+    // the inputs could not be computed again
+    victim = -1;
+    for (int i=0; i<N_FIELDS; ++i)
+      if (has_field(Field_id(i)) && i != LUMINANCE && i != USER_FUNCTION &&
+          (victim < 0 ||
+           (!valid_[i] && valid_[victim]) ||
+           (valid_[i] == valid_[victim] && last_use_[i] < last_use_[victim])))
+        victim = i;
+    if (victim < 0) break;
+
+    total -= bytes(Field_id(victim));
+    release(Field_id(victim));
+  }
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshView::
+spawn_team(Kernel _kernel, Field_id _writes)
+{
+#ifdef _OPENMP
+  if (omp_get_level() == 0)
+  {
+    allocate_outputs(_writes);
+#pragma omp parallel
+#pragma omp single
+    (this->*_kernel)();
+    return true;
+  }
+#endif
+  return false;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+const char*
+MeshView::
+field_name(Field_id _id)
+{
+  static const char* names[N_FIELDS] = { "vertex weight", "edge weight",
+    "mean curvature", "uniform mean curvature", "gauss curvature",
+    "triangle shape", "average edge length", "MeshDOG f", "MeshDOG DoG",
+    "MeshDOG f channels", "MeshDOG DoG channels", "geodesic distance",
+    "color luminance", "user function" };
+  return names[_id];
+}
+
+
+size_t
+MeshView::
+field_bytes() const
+{
+  size_t b(0);
+  for (int i=0; i<N_FIELDS; ++i)
+    b += bytes(Field_id(i));
+  return b;
+}
+
+
+size_t
+MeshView::
+bytes() const
+{
+  return (x_.capacity() + y_.capacity() + z_.capacity()) * sizeof(float)
+    + (offsets_.capacity() + neighbors_.capacity() + ring_edges_.capacity()
+       + ring_faces_.capacity() + edges_.capacity() + faces_.capacity()) * sizeof(unsigned int)
+    + rings_.bytes() + field_bytes();
+}
+
+
+void
+MeshView::
+report(std::ostream& _os) const
+{
+  const double kb = 1.0 / 1024;
+
+  _os << "  positions              " << (x_.capacity() + y_.capacity() + z_.capacity()) * sizeof(float) * kb << " KB\n"
+      << "  connectivity           " << (offsets_.capacity() + neighbors_.capacity() + ring_edges_.capacity()
+                                         + ring_faces_.capacity() + edges_.capacity() + faces_.capacity())
+                                        * sizeof(unsigned int) * kb << " KB\n";
+  if (!rings_.empty())
+    _os << "  ring table             " << rings_.bytes() * kb << " KB, "
+        << rings_.n_entries() << " entries for " << (ring_radius_ > 0.0f ? "radius " : "rings ")
+        << rings_.reach() << "\n";
+  for (int i=0; i<N_FIELDS; ++i)
+    if (has_field(Field_id(i)))
+    {
+      std::string name(field_name(Field_id(i)));
+      name.resize(23, ' ');
+      _os << "  " << name << bytes(Field_id(i)) * kb << " KB"
+          << (valid_[i] ? "\n" : " (stale)\n");
+    }
+  _os << "  view total             " << bytes() * kb << " KB\n";
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshView::
+calc_weights()
+{
+  if (spawn_team(&MeshView::calc_weights, EWEIGHT)) return;
+
+  const long long  ne(n_edges()), nf(n_faces()), nv(n_vertices());
+  Field&           eweight(allocate(EWEIGHT));
+  Field&           vweight(allocate(VWEIGHT));
+  Field            area(nf);
+
+
+  // cotangents of the angles opposite to each edge
+#pragma omp taskloop default(shared) grainsize(grain)
+  for (long long e=0; e<ne; ++e)
+  {
+    const unsigned int*  v = &edges_[4*e];
+    float                w(0.0);
+
+    for (int k=2; k<4; ++k)
+    {
+      float d0x = x_[v[0]] - x_[v[k]], d0y = y_[v[0]] - y_[v[k]], d0z = z_[v[0]] - z_[v[k]];
+      float d1x = x_[v[1]] - x_[v[k]], d1y = y_[v[1]] - y_[v[k]], d1z = z_[v[1]] - z_[v[k]];
+      float l0 = sqrtf(d0x*d0x + d0y*d0y + d0z*d0z);
+      float l1 = sqrtf(d1x*d1x + d1y*d1y + d1z*d1z);
+      d0x /= l0;  d0y /= l0;  d0z /= l0;
+      d1x /= l1;  d1y /= l1;  d1z /= l1;
+      w += 1.0 / tan(acos(std::min(0.99f, std::max(-0.99f, d0x*d1x + d0y*d1y + d0z*d1z))));
+    }
+
+    eweight[e] = std::max(0.0f, w);
+  }
+
+
+  // a third of the incident triangle areas
+#pragma omp taskloop default(shared) grainsize(grain)
+  for (long long f=0; f<nf; ++f)
+  {
+    const unsigned int* t = &faces_[3*f];
+    float ux = x_[t[1]] - x_[t[0]], uy = y_[t[1]] - y_[t[0]], uz = z_[t[1]] - z_[t[0]];
+    float wx = x_[t[2]] - x_[t[0]], wy = y_[t[2]] - y_[t[0]], wz = z_[t[2]] - z_[t[0]];
+    float cx = uy*wz - uz*wy, cy = uz*wx - ux*wz, cz = ux*wy - uy*wx;
+    area[f] = sqrtf(cx*cx + cy*cy + cz*cz) * 0.5f * 0.3333f;
+  }
+
+#pragma omp taskloop default(shared) grainsize(grain)
+  for (long long v=0; v<nv; ++v)
+  {
+    float a(0.0);
+    for (unsigned int i=offsets_[v]; i<offsets_[v+1]; ++i)
+      if (ring_faces_[i] != no_face)
+        a += area[ring_faces_[i]];
+    vweight[v] = 1.0 / (2.0 * a);
+  }
+
+  validate(EWEIGHT);
+  validate(VWEIGHT);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshView::
+calc_mean_curvature()
+{
+  if (spawn_team(&MeshView::calc_mean_curvature, CURVATURE)) return;
+
+  const long long  n(n_vertices());
+  const Field&     eweight(require(EWEIGHT));
+  const Field&     vweight(require(VWEIGHT));
+  Field&           curv(allocate(CURVATURE));
+
+#pragma omp taskloop default(shared) grainsize(grain)
+  for (long long v=0; v<n; ++v)
+  {
+    float lx(0), ly(0), lz(0), w;
+
+    for (unsigned int i=offsets_[v]; i<offsets_[v+1]; ++i)
+    {
+      const unsigned int j = neighbors_[i];
+      w   = eweight[ring_edges_[i]];
+      lx += w * (x_[j] - x_[v]);
+      ly += w * (y_[j] - y_[v]);
+      lz += w * (z_[j] - z_[v]);
+    }
+
+    // half of the norm of LB(v)
+    lx *= vweight[v];  ly *= vweight[v];  lz *= vweight[v];
+    curv[v] = sqrtf(lx*lx + ly*ly + lz*lz) / 2;
+  }
+
+  validate(CURVATURE);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshView::
+calc_uniform_mean_curvature()
+{
+  if (spawn_team(&MeshView::calc_uniform_mean_curvature, UNICURVATURE)) return;
+
+  const long long  n(n_vertices());
+  Field&           curv(allocate(UNICURVATURE));
+
+#pragma omp taskloop default(shared) grainsize(grain)
+  for (long long v=0; v<n; ++v)
+  {
+    float lx(0), ly(0), lz(0), counter(0);
+
+    for (unsigned int i=offsets_[v]; i<offsets_[v+1]; ++i)
+    {
+      lx += x_[neighbors_[i]];
+      ly += y_[neighbors_[i]];
+      lz += z_[neighbors_[i]];
+      counter++;
+    }
+
+    // Lu(v), NaN for single points
+    lx = lx / counter - x_[v];
+    ly = ly / counter - y_[v];
+    lz = lz / counter - z_[v];
+    curv[v] = sqrtf(lx*lx + ly*ly + lz*lz) / 2;
+  }
+
+  validate(UNICURVATURE);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshView::
+calc_gauss_curvature()
+{
+  if (spawn_team(&MeshView::calc_gauss_curvature, GAUSSCURVATURE)) return;
+
+  const long long  n(n_vertices());
+  const Field&     vweight(require(VWEIGHT));
+  Field&           curv(allocate(GAUSSCURVATURE));
+
+#pragma omp taskloop default(shared) grainsize(grain)
+  for (long long v=0; v<n; ++v)
+  {
+    const unsigned int  begin(offsets_[v]), end(offsets_[v+1]);
+    float               angles(0.0), cos_angle;
+
+    // angles between consecutive ring neighbors, the last one pairs
+    // with the first like the OpenMesh circulator
+    for (unsigned int i=begin; i<end; ++i)
+    {
+      const unsigned int a = neighbors_[i];
+      const unsigned int b = neighbors_[i+1 < end ? i+1 : begin];
+      float d0x = x_[a] - x_[v], d0y = y_[a] - y_[v], d0z = z_[a] - z_[v];
+      float d1x = x_[b] - x_[v], d1y = y_[b] - y_[v], d1z = z_[b] - z_[v];
+
+      cos_angle = (d0x*d1x + d0y*d1y + d0z*d1z)
+        / (sqrtf(d0x*d0x + d0y*d0y + d0z*d0z) * sqrtf(d1x*d1x + d1y*d1y + d1z*d1z));
+      cos_angle = std::min(1.0f, std::max(-1.0f, cos_angle));
+      angles += acos(cos_angle);
+    }
+
+    curv[v] = 2 * vweight[v] * (2 * 3.1415926 - angles);
+  }
+
+  validate(GAUSSCURVATURE);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshView::
+calc_triangle_quality()
+{
+  if (spawn_team(&MeshView::calc_triangle_quality, TSHAPE)) return;
+
+  const long long  n(n_faces());
+  Field&           shape(allocate(TSHAPE));
+
+#pragma omp taskloop default(shared) grainsize(grain)
+  for (long long f=0; f<n; ++f)
+  {
+    const unsigned int* t = &faces_[3*f];
+    float ux = x_[t[1]] - x_[t[0]], uy = y_[t[1]] - y_[t[0]], uz = z_[t[1]] - z_[t[0]];
+    float wx = x_[t[2]] - x_[t[0]], wy = y_[t[2]] - y_[t[0]], wz = z_[t[2]] - z_[t[0]];
+    float sx = x_[t[1]] - x_[t[2]], sy = y_[t[1]] - y_[t[2]], sz = z_[t[1]] - z_[t[2]];
+    float a = sqrtf(ux*ux + uy*uy + uz*uz);
+    float b = sqrtf(wx*wx + wy*wy + wz*wz);
+    float c = sqrtf(sx*sx + sy*sy + sz*sz);
+    float cx = uy*wz - uz*wy, cy = uz*wx - ux*wz, cz = ux*wy - uy*wx;
+    float denom = sqrtf(cx*cx + cy*cy + cz*cz);
+
+    // circumradius over shortest edge, FLT_MAX for degenerate triangles
+    if (denom < FLT_MIN)
+      shape[f] = FLT_MAX;
+    else
+      shape[f] = ((a * b * c) / (2 * denom)) / std::min(a, std::min(b, c));
+  }
+
+  validate(TSHAPE);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshView::
+calc_edge_average()
+{
+  if (spawn_team(&MeshView::calc_edge_average, EAVG)) return;
+
+  const long long  n(n_vertices());
+  Field&           eavg(allocate(EAVG));
+
+#pragma omp taskloop default(shared) grainsize(grain)
+  for (long long v=0; v<n; ++v)
+  {
+    float e(0.0);
+
+    for (unsigned int i=offsets_[v]; i<offsets_[v+1]; ++i)
+    {
+      const unsigned int j = neighbors_[i];
+      e += sqrtf((x_[v]-x_[j])*(x_[v]-x_[j]) + (y_[v]-y_[j])*(y_[v]-y_[j]) + (z_[v]-z_[j])*(z_[v]-z_[j]));
+    }
+
+    eavg[v] = valence(v) ? e / valence(v) : 0.0f;
+  }
+
+  validate(EAVG);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshView::
+init_meshdog()
+{
+  if (spawn_team(&MeshView::init_meshdog, DOG_F)) return;
+
+  const long long     n(n_vertices());
+  const unsigned int  w(dog_width());
+  Field&              f(allocate(w > 1 ? DOG_CHANNEL_F : DOG_F));
+  Field&              dog(allocate(w > 1 ? DOG_CHANNEL_DOG : DOG_DOG));
+
+  // fields that were never set and the padding are 0
+  const float*  src[max_dog_channels] = { 0 };
+  for (size_t c=0; c<n_dog_channels_; ++c)
+  {
+    const Field& channel(require(dog_channels_[c]));
+    if (channel.size() == size_t(n)) src[c] = &channel[0];
+  }
+
+#pragma omp taskloop default(shared) grainsize(grain)
+  for (long long v=0; v<n; ++v)
+    for (unsigned int c=0; c<w; ++c)
+    {
+      f[w*v+c]   = src[c] ? src[c][v] : 0.0f;
+      dog[w*v+c] = 0.0f;
+    }
+
+  dog_level_ = 0;
+  if (w > 1)
+  {
+    validate(DOG_CHANNEL_F);
+    validate(DOG_CHANNEL_DOG);
+    allocate(DOG_F);
+    allocate(DOG_DOG);
+    show_dog_channel();
+  }
+  validate(DOG_F);
+  validate(DOG_DOG);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+template <int Width>
+void
+MeshView::
+dog_pass(float _theta_scale, float* _f, float* _dog)
+{
+  const long long  n(n_vertices());
+
+  // in place, later vertices already see the new level of earlier ones;
+  // single points keep their value
+  if (!dog_jacobi_)
+  {
+    for (long long v=0; v<n; ++v)
+      if (offsets_[v] != offsets_[v+1])
+      {
+        dog_vertex<Width>(v, _theta_scale, _f, _dog);
+        for (int c=0; c<Width; ++c)
+          _f[Width*v+c] += _dog[Width*v+c];
+      }
+    return;
+  }
+
+  // all differences first, so every vertex sees the previous level
+#pragma omp taskloop default(shared) grainsize(grain)
+  for (long long v=0; v<n; ++v)
+    if (offsets_[v] != offsets_[v+1])
+      dog_vertex<Width>(v, _theta_scale, _f, _dog);
+
+#pragma omp taskloop default(shared) grainsize(grain)
+  for (long long v=0; v<n; ++v)
+    if (offsets_[v] != offsets_[v+1])
+      for (int c=0; c<Width; ++c)
+        _f[Width*v+c] += _dog[Width*v+c];
+}
+
+
+template <int Width>
+void
+MeshView::
+dog_vertex(long long _v, float _theta_scale, const float* _f, float* _dog) const
+{
+  const float  theta = _theta_scale * pow(2, 1.0/3.0) * fields_[EAVG][_v];
+  float        f1[Width], K(0), k;
+
+  for (int c=0; c<Width; ++c)
+    f1[c] = 0.0f;
+
+  if (!rings_.empty())
+  {
+    for (unsigned int i=rings_.begin(_v); i<rings_.end(_v); ++i)
+    {
+      const float* fj = _f + Width*rings_.neighbor(i);
+      k = gaussian(rings_.distance(i), theta);
+      K += k;
+#pragma omp simd
+      for (int c=0; c<Width; ++c)
+        f1[c] += fj[c] * k;
+    }
+  }
+  else
+  {
+    for (unsigned int i=offsets_[_v]; i<offsets_[_v+1]; ++i)
+    {
+      const unsigned int j = neighbors_[i];
+      const float*       fj = _f + Width*j;
+      k = gaussian(sqrtf((x_[_v]-x_[j])*(x_[_v]-x_[j]) + (y_[_v]-y_[j])*(y_[_v]-y_[j]) + (z_[_v]-z_[j])*(z_[_v]-z_[j])), theta);
+      K += k;
+#pragma omp simd
+      for (int c=0; c<Width; ++c)
+        f1[c] += fj[c] * k;
+    }
+  }
+
+#pragma omp simd
+  for (int c=0; c<Width; ++c)
+    _dog[Width*_v+c] = K > 0.0f ? f1[c] / K - _f[Width*_v+c] : 0.0f;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshView::
+detect_meshdog(int _iters)
+{
+  // the table of wide neighborhoods, with a team of its own if possible
+  if (rings_.empty() && (ring_k_ > 1 || ring_radius_ > 0.0f) && n_vertices())
+  {
+    if (ring_radius_ > 0.0f)
+      rings_.build_geodesic(&offsets_[0], &neighbors_[0], n_vertices(),
+                            &x_[0], &y_[0], &z_[0], 1, &require(EAVG)[0], ring_radius_);
+    else
+      rings_.build_rings(&offsets_[0], &neighbors_[0], n_vertices(),
+                         &x_[0], &y_[0], &z_[0], 1, ring_k_);
+  }
+
+#ifdef _OPENMP
+  if (omp_get_level() == 0)
+  {
+    allocate_outputs(DOG_DOG);
+#pragma omp parallel
+#pragma omp single
+    detect_meshdog(_iters);
+    return;
+  }
+#endif
+
+  require(EAVG);
+
+  if (!dog_valid())
+    init_meshdog();
+
+  // fewer passes over the table, their variances add up to those of
+  // _iters 1-ring convolutions
+  const int    passes(rings_.empty() ? _iters : rings_.passes(_iters));
+  const float  scale(rings_.empty() ? 1.0f : rings_.theta_scale(_iters));
+
+  if (dog_width() > 1)
+  {
+    float* f(&fields_[DOG_CHANNEL_F][0]);
+    float* dog(&fields_[DOG_CHANNEL_DOG][0]);
+    for (int pass=0; pass<passes; ++pass)
+      dog_pass<max_dog_channels>(scale, f, dog);
+
+    show_dog_channel();
+    validate(DOG_CHANNEL_F);
+    validate(DOG_CHANNEL_DOG);
+  }
+  else
+  {
+    float* f(&fields_[DOG_F][0]);
+    float* dog(&fields_[DOG_DOG][0]);
+    for (int pass=0; pass<passes; ++pass)
+      dog_pass<1>(scale, f, dog);
+  }
+
+  dog_level_ += _iters;
+  validate(DOG_F);
+  validate(DOG_DOG);
+}
+
+
+void
+MeshView::
+show_dog_channel()
+{
+  if (spawn_team(&MeshView::show_dog_channel, DOG_F)) return;
+
+  const long long     n(n_vertices());
+  const unsigned int  w(dog_width());
+  const Field&        cf(fields_[DOG_CHANNEL_F]);
+  const Field&        cdog(fields_[DOG_CHANNEL_DOG]);
+  Field&              f(fields_[DOG_F]);
+  Field&              dog(fields_[DOG_DOG]);
+
+#pragma omp taskloop default(shared) grainsize(grain)
+  for (long long v=0; v<n; ++v)
+  {
+    f[v]   = cf[w*v+dog_channel_];
+    dog[v] = cdog[w*v+dog_channel_];
+  }
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshView::
+smooth(unsigned int _iters)
+{
+  const size_t  n(n_vertices());
+  const Field&  eweight(require(EWEIGHT));
+
+  // in place, later vertices already see the moved earlier ones
+  for (unsigned int iter=0; iter<_iters; ++iter)
+    for (size_t v=0; v<n; ++v)
+    {
+      float lx(0), ly(0), lz(0), w, ww(0);
+
+      if (!valence(v)) continue;
+
+      for (unsigned int i=offsets_[v]; i<offsets_[v+1]; ++i)
+      {
+        const unsigned int j = neighbors_[i];
+        w   = eweight[ring_edges_[i]];
+        lx += w * (x_[j] - x_[v]);
+        ly += w * (y_[j] - y_[v]);
+        lz += w * (z_[j] - z_[v]);
+        ww += w;
+      }
+
+      x_[v] += lx / ww / 2;
+      y_[v] += ly / ww / 2;
+      z_[v] += lz / ww / 2;
+    }
+
+  invalidate();
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshView::
+uniform_smooth(unsigned int _iters)
+{
+  const size_t n(n_vertices());
+
+  for (unsigned int iter=0; iter<_iters; ++iter)
+    for (size_t v=0; v<n; ++v)
+    {
+      float cx(0), cy(0), cz(0), counter(0);
+
+      if (!valence(v)) continue;
+
+      for (unsigned int i=offsets_[v]; i<offsets_[v+1]; ++i)
+      {
+        cx += x_[neighbors_[i]];
+        cy += y_[neighbors_[i]];
+        cz += z_[neighbors_[i]];
+        counter++;
+      }
+
+      x_[v] += (cx / counter - x_[v]) / 2;
+      y_[v] += (cy / counter - y_[v]) / 2;
+      z_[v] += (cz / counter - z_[v]) / 2;
+    }
+
+  invalidate();
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+float
+MeshView::
+gaussian(float _edge_length, float _theta)
+{
+  return exp(-pow(_edge_length, 2) / (2 * pow(_theta, 2)))
+    / (_theta * sqrt(2 * M_PI));
+}
+
+
+//=============================================================================
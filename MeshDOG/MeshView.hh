@@ -0,0 +1,329 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS MeshView
+//
+//=============================================================================
+
+
+#ifndef MESH_VIEW_HH
+#define MESH_VIEW_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include "Numa.hh"
+#include "RingTable.hh"
+#include <OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh>
+#include <iosfwd>
+#include <vector>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class MeshView MeshView.hh
+    Structure-of-arrays copy of a mesh for the numeric kernels.
+
+    Positions are kept as separate x, y and z arrays, the connectivity as
+    32-bit indices: the 1-ring of every vertex in the order of its
+    outgoing halfedges (neighbor, edge and face per entry), four vertices
+    per edge for the cotangent weights and three per face. The scalar
+    fields live next to it. The kernels are those of QualityViewer and
+    SmoothingViewer and visit the rings in the order OpenMesh does, so
+    they compute the same values. pull() and push_points() copy between
+    the view and the mesh. The fields exist from the kernel that writes
+    them until release(), see report() for where the memory goes.
+
+    Fields are computed lazily: require() runs the kernel of a field,
+    and before that those of the fields it reads (positions -> weights
+    -> mean curvature -> DoG levels, ...), unless they are up to date.
+    Moving the points invalidates all fields, their memory is kept for
+    the recomputation. Kernels called directly always recompute.
+
+    The kernel loops are OpenMP tasks. A kernel called on its own starts
+    a team for them; require() of several fields runs every stale kernel
+    as a task ordered by the fields it reads, so independent kernels and
+    their loops share one team and no threads are added. The fields are
+    allocated before the team starts, the first touch spreads them over
+    the NUMA nodes, but the task chunks do not follow its placement.
+
+    The DoG convolves up to max_dog_channels per-vertex fields at once,
+    interleaved in DOG_CHANNEL_F and DOG_CHANNEL_DOG; each Gaussian
+    weight is computed once per neighbor and applied to all of them.
+    DOG_F and DOG_DOG hold the channel shown, for a single one they are
+    the whole state.
+**/
+
+class MeshView
+{
+public:
+
+  typedef OpenMesh::TriMesh_ArrayKernelT<>                             Mesh;
+  typedef std::vector<float, FirstTouchAllocator<float> >              Field;
+  typedef std::vector<unsigned int, FirstTouchAllocator<unsigned int> > Indices;
+
+  /// the scalar fields of the view, EWEIGHT is per edge, TSHAPE per face,
+  /// the DOG_CHANNEL fields dog_width() per vertex; GEODESIC has no
+  /// kernel, it is set from HeatGeodesics, nor have the inputs LUMINANCE
+  /// of the vertex colors and USER_FUNCTION of a file, which also stay
+  /// when the points move and are never trimmed
+  enum Field_id { VWEIGHT, EWEIGHT, CURVATURE, UNICURVATURE, GAUSSCURVATURE,
+                  TSHAPE, EAVG, DOG_F, DOG_DOG, DOG_CHANNEL_F, DOG_CHANNEL_DOG,
+                  GEODESIC, LUMINANCE, USER_FUNCTION, N_FIELDS };
+
+  /// per-vertex fields the DoG convolves together at most
+  enum { max_dog_channels = 4 };
+
+  /// ring entry of a boundary halfedge that has no face
+  static const unsigned int no_face = ~0u;
+
+  MeshView();
+
+  /// copy connectivity and positions of _mesh, release all fields
+  void pull(const Mesh& _mesh);
+
+  /// copy the positions of _mesh, the connectivity has to be the same
+  void pull_points(const Mesh& _mesh);
+
+  /// write the positions back to _mesh
+  void push_points(Mesh& _mesh) const;
+
+  /// copy _n values into a field, e.g. from a cache, it counts as
+  /// up to date with the current positions
+  void set_field(Field_id _id, const float* _data, size_t _n);
+
+  /// field _id up to date with the positions, computed along with the
+  /// fields it depends on if needed; references stay valid until the
+  /// field is released or trimmed
+  const Field& require(Field_id _id);
+
+  /// bring _n fields up to date at once, independent kernels run
+  /// concurrently
+  void require(const Field_id* _ids, size_t _n);
+
+  /// field is up to date with the positions
+  bool is_valid(Field_id _id) const { return valid_[_id]; }
+
+  /// changes whenever field _id is written, for caches derived from it
+  unsigned int revision(Field_id _id) const { return revision_[_id]; }
+
+  /// the positions changed, all fields are stale
+  void invalidate();
+
+  /// number of convolutions require() applies for DOG_F and DOG_DOG
+  void set_dog_iterations(int _iters);
+
+  /// convolutions DOG_F has had, require() continues from this level
+  int dog_level() const { return dog_level_; }
+
+  /** convolve over the _k-rings, or within _radius average edge lengths
+      along the edges, in fewer wide passes, see RingTable; 1 and 0 for
+      the 1-rings. The DoG levels start over, the table is built by the
+      next detection and dropped when the points move **/
+  void set_dog_rings(unsigned int _k);
+  void set_dog_geodesic(float _radius);
+  const RingTable& rings() const { return rings_; }
+
+  /** update the DoG in place vertex by vertex (Gauss-Seidel, as the
+      viewer always did), or after each pass (Jacobi): in parallel and
+      independent of the vertex order, as MeshKernel. The DoG levels
+      start over **/
+  void set_dog_jacobi(bool _jacobi);
+  bool dog_jacobi() const { return dog_jacobi_; }
+
+  /// convolve the _n per-vertex fields _ids together, UNICURVATURE by
+  /// default; the DoG levels start over and DOG_F and DOG_DOG show the
+  /// first one
+  void set_dog_channels(const Field_id* _ids, size_t _n);
+  size_t   n_dog_channels() const { return n_dog_channels_; }
+  Field_id dog_channel_id(size_t _ch) const { return dog_channels_[_ch]; }
+
+  /// show channel _ch in DOG_F and DOG_DOG, right away if the channels
+  /// are up to date
+  void set_dog_channel(size_t _ch);
+  size_t dog_channel() const { return dog_channel_; }
+
+  /// floats per vertex of the DOG_CHANNEL fields, padded to a vector
+  /// for several channels; they stay empty for one
+  unsigned int dog_width() const { return n_dog_channels_ > 1 ? max_dog_channels : 1; }
+
+  Field&       field(Field_id _id)       { return fields_[_id]; }
+  const Field& field(Field_id _id) const { return fields_[_id]; }
+
+  size_t n_vertices() const { return x_.size(); }
+  size_t n_edges()    const { return edges_.size() / 4; }
+  size_t n_faces()    const { return faces_.size() / 3; }
+
+  unsigned int valence(size_t _v) const { return offsets_[_v+1] - offsets_[_v]; }
+
+  /// 1-ring of _v for solvers built on the view: neighbor(i) across the
+  /// edge ring_edge(i), i in [ring_begin(_v), ring_end(_v))
+  unsigned int ring_begin(size_t _v) const { return offsets_[_v]; }
+  unsigned int ring_end(size_t _v)   const { return offsets_[_v+1]; }
+  unsigned int neighbor(size_t _i)   const { return neighbors_[_i]; }
+  unsigned int ring_edge(size_t _i)  const { return ring_edges_[_i]; }
+
+  /// the three vertices of face _f
+  const unsigned int* face(size_t _f) const { return &faces_[3*_f]; }
+
+  /// position of _v
+  void point(size_t _v, float* _p) const { _p[0] = x_[_v];  _p[1] = y_[_v];  _p[2] = z_[_v]; }
+
+
+  /// fields are allocated by the kernels writing them, false before that
+  /// and after release()
+  bool has_field(Field_id _id) const { return !fields_[_id].empty(); }
+
+  /// free a field once its last consumer is done
+  void release(Field_id _id) { Field().swap(fields_[_id]);  valid_[_id] = false; }
+
+  /// release stale fields, then the least recently required ones, until
+  /// the fields take at most _budget bytes
+  void trim(size_t _budget);
+
+  /// memory of one field, of all fields, of the whole view
+  size_t bytes(Field_id _id) const { return fields_[_id].capacity() * sizeof(float); }
+  size_t field_bytes() const;
+  size_t bytes() const;
+
+  /// name of a field in reports
+  static const char* field_name(Field_id _id);
+
+  /// bytes per field, positions and connectivity, and the total
+  void report(std::ostream& _os) const;
+
+
+  /// cotangent edge weights (EWEIGHT) and inverse vertex areas (VWEIGHT)
+  void calc_weights();
+
+  /// Laplace-Beltrami mean curvature from the weights (CURVATURE)
+  void calc_mean_curvature();
+
+  /// uniform Laplacian mean curvature (UNICURVATURE), NaN for single points
+  void calc_uniform_mean_curvature();
+
+  /// angle deficit Gaussian curvature (GAUSSCURVATURE)
+  void calc_gauss_curvature();
+
+  /// circumradius over shortest edge per face (TSHAPE)
+  void calc_triangle_quality();
+
+  /// average edge length around each vertex (EAVG)
+  void calc_edge_average();
+
+  /// DOG_F from the channel fields, UNICURVATURE by default, DOG_DOG = 0
+  void init_meshdog();
+
+  /// _iters more convolutions of all channels, DOG_DOG holds the
+  /// last difference; single points are left alone. With rings set,
+  /// fewer wide ones of about the same total width
+  void detect_meshdog(int _iters);
+
+  /// Laplace-Beltrami smoothing with EWEIGHT, in place vertex by vertex,
+  /// invalidates all fields
+  void smooth(unsigned int _iters);
+
+  /// uniform Laplacian smoothing, in place vertex by vertex, invalidates
+  /// all fields
+  void uniform_smooth(unsigned int _iters);
+
+  /// Gaussian k(||vivj||) of the MeshDOG paper
+  static float gaussian(float _edge_length, float _theta);
+
+
+private:
+
+  /// field _id sized for its kind of element, for a kernel to fill
+  Field& allocate(Field_id _id);
+
+  /// allocate() the fields the kernel of _id writes; outside of a team,
+  /// so that Numa::first_touch() has all threads
+  void allocate_outputs(Field_id _id);
+
+  typedef void (MeshView::*Kernel)();
+
+  /// run _kernel on a new team and return true, unless already on one;
+  /// the fields of _writes are allocated before
+  bool spawn_team(Kernel _kernel, Field_id _writes);
+
+  /// set _need for _id and the fields it reads if they are stale
+  void mark_stale(Field_id _id, bool* _need) const;
+
+  /// DOG_F, DOG_DOG and the channels they come from are up to date
+  bool dog_valid() const;
+
+  /// one convolution of the Width interleaved channels of _f, _dog
+  /// receives the differences; over rings_ if it is built, with a
+  /// Gaussian _theta_scale times as wide
+  template <int Width>
+  void dog_pass(float _theta_scale, float* _f, float* _dog);
+
+  /// the differences of vertex _v for dog_pass()
+  template <int Width>
+  void dog_vertex(long long _v, float _theta_scale, const float* _f, float* _dog) const;
+
+  /// copy the shown channel to DOG_F and DOG_DOG
+  void show_dog_channel();
+
+  /// next value of clock_, kernels may run concurrently
+  unsigned int tick();
+
+  /// a kernel has written field _id
+  void validate(Field_id _id) { valid_[_id] = true;  revision_[_id] = tick(); }
+
+  Field    x_, y_, z_;
+  Indices  offsets_;     // n_vertices+1
+  Indices  neighbors_;   // to-vertex of each outgoing halfedge
+  Indices  ring_edges_;  // its edge
+  Indices  ring_faces_;  // its face or no_face
+  Indices  edges_;       // to-vertices of both halfedges and of their next ones
+  Indices  faces_;       // three vertices per face
+  Field    fields_[N_FIELDS];
+
+  bool          valid_[N_FIELDS];
+  unsigned int  revision_[N_FIELDS];
+  unsigned int  last_use_[N_FIELDS];  // clock_ of the last require()
+  unsigned int  clock_;
+  int           dog_iters_;           // convolutions require() asks for
+  int           dog_level_;           // convolutions DOG_F has had
+  RingTable     rings_;               // wide neighborhoods of the DoG
+  unsigned int  ring_k_;              // rings of rings_, 1 for none
+  float         ring_radius_;         // or its geodesic radius
+  bool          dog_jacobi_;          // update after each pass
+  Field_id      dog_channels_[max_dog_channels];  // fields the DoG convolves
+  size_t        n_dog_channels_;
+  size_t        dog_channel_;         // the one in DOG_F and DOG_DOG
+};
+
+
+//=============================================================================
+#endif // MESH_VIEW_HH defined
+//=============================================================================
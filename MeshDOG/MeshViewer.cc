@@ -41,9 +41,13 @@
 
 #include <OpenMesh/Core/IO/MeshIO.hh>
 #include "MeshViewer.hh"
+#include "MeshLoader.hh"
 #include "gl.hh"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <deque>
+#include <string.h>
 
 
 //== IMPLEMENTATION ========================================================== 
@@ -51,7 +55,15 @@
 
 MeshViewer::
 MeshViewer(const char* _title, int _width, int _height)
-  : GlutExaminer(_title, _width, _height)
+  : GlutExaminer(_title, _width, _height),
+    reorder_mode_(REORDER_NONE),
+    native_loader_(true),
+    read_colors_(false),
+    colors_loaded_(false),
+    weld_(false),
+    weld_epsilon_(0.0f),
+    use_cache_(false),
+    cache_loaded_(false)
 {
   mesh_.request_face_normals();
   mesh_.request_vertex_normals();
@@ -72,9 +84,26 @@ bool
 MeshViewer::
 open_mesh(const char* _filename)
 {
-  // load mesh
-  if (OpenMesh::IO::read_mesh(mesh_, _filename))
+  vertex_order_.clear();
+  cache_loaded_ = false;
+  colors_loaded_ = false;
+
+  // load mesh, skipping the parser if the cache is up to date and
+  // falling back to OpenMesh for formats MeshLoader does not handle;
+  // only OpenMesh reads colors
+  OpenMesh::IO::Options options(read_colors_ ? OpenMesh::IO::Options::VertexColor
+                                             : OpenMesh::IO::Options::Default);
+  if ((!read_colors_ && use_cache_ && load_cache(_filename)) ||
+      (!read_colors_ && native_loader_ && load_native(_filename)) ||
+      OpenMesh::IO::read_mesh(mesh_, _filename, options))
   {
+    colors_loaded_ = read_colors_ && options.check(OpenMesh::IO::Options::VertexColor);
+
+    // improve memory locality of the 1-ring loops
+    // (a cached mesh is stored in its final order)
+    if (reorder_mode_ != REORDER_NONE && !cache_loaded_)
+      reorder_mesh();
+
     // set center and radius
     Mesh::ConstVertexIter  v_it(mesh_.vertices_begin()), 
                            v_end(mesh_.vertices_end());
@@ -90,7 +119,10 @@ open_mesh(const char* _filename)
 
 
     // compute face & vertex normals
-    mesh_.update_normals();
+    if (cache_loaded_)
+      mesh_.update_face_normals();
+    else
+      mesh_.update_normals();
 
 
     // update face indices for faster rendering
@@ -110,6 +142,375 @@ open_mesh(const char* _filename)
 //-----------------------------------------------------------------------------
 
 
+// spread the lower 10 bits of _v so that two zero bits follow each bit
+static unsigned int
+expand_bits(unsigned int _v)
+{
+  _v = (_v * 0x00010001u) & 0xFF0000FFu;
+  _v = (_v * 0x00000101u) & 0x0F00F00Fu;
+  _v = (_v * 0x00000011u) & 0xC30C30C3u;
+  _v = (_v * 0x00000005u) & 0x49249249u;
+  return _v;
+}
+
+
+void
+MeshViewer::
+reorder_mesh()
+{
+  const size_t      nv(mesh_.n_vertices()), nf(mesh_.n_faces());
+  Mesh::VertexIter  v_it, v_end(mesh_.vertices_end());
+  std::vector<int>  order;  // new index -> old index
+
+  if (nv == 0) return;
+  order.reserve(nv);
+
+
+  if (reorder_mode_ == REORDER_MORTON)
+  {
+    // sort vertices along a Z-order curve through the bounding box
+    Mesh::Point  bbMin, bbMax, scale;
+    bbMin = bbMax = mesh_.point(*mesh_.vertices_begin());
+    for (v_it=mesh_.vertices_begin(); v_it!=v_end; ++v_it)
+    {
+      bbMin.minimize(mesh_.point(v_it));
+      bbMax.maximize(mesh_.point(v_it));
+    }
+    for (int i=0; i<3; ++i)
+      scale[i] = (bbMax[i] > bbMin[i]) ? 1023.0f / (bbMax[i] - bbMin[i]) : 0.0f;
+
+    std::vector< std::pair<unsigned int, int> > codes;
+    codes.reserve(nv);
+    for (v_it=mesh_.vertices_begin(); v_it!=v_end; ++v_it)
+    {
+      const Mesh::Point& p = mesh_.point(v_it);
+      unsigned int x = (unsigned int)((p[0] - bbMin[0]) * scale[0]);
+      unsigned int y = (unsigned int)((p[1] - bbMin[1]) * scale[1]);
+      unsigned int z = (unsigned int)((p[2] - bbMin[2]) * scale[2]);
+      codes.push_back(std::make_pair((expand_bits(x) << 2) |
+                                     (expand_bits(y) << 1) |
+                                      expand_bits(z),
+                                     v_it.handle().idx()));
+    }
+    std::sort(codes.begin(), codes.end());
+
+    for (size_t i=0; i<nv; ++i)
+      order.push_back(codes[i].second);
+  }
+
+  else // REORDER_RCM
+  {
+    // reverse Cuthill-McKee: breadth-first search from low-valence vertices,
+    // visiting neighbors by increasing valence
+    std::vector< std::pair<unsigned int, int> >  seeds, ring;
+    std::vector<bool>                            visited(nv, false);
+    std::deque<int>                              queue;
+    Mesh::VertexVertexIter                       vv_it;
+
+    seeds.reserve(nv);
+    for (v_it=mesh_.vertices_begin(); v_it!=v_end; ++v_it)
+      seeds.push_back(std::make_pair(mesh_.valence(v_it), v_it.handle().idx()));
+    std::sort(seeds.begin(), seeds.end());
+
+    for (size_t s=0; s<nv; ++s)
+    {
+      if (visited[seeds[s].second]) continue;
+
+      visited[seeds[s].second] = true;
+      queue.push_back(seeds[s].second);
+
+      while (!queue.empty())
+      {
+        int v = queue.front();
+        queue.pop_front();
+        order.push_back(v);
+
+        ring.clear();
+        for (vv_it=mesh_.vv_iter(Mesh::VertexHandle(v)); vv_it; ++vv_it)
+          if (!visited[vv_it.handle().idx()])
+          {
+            visited[vv_it.handle().idx()] = true;
+            ring.push_back(std::make_pair(mesh_.valence(vv_it), vv_it.handle().idx()));
+          }
+        std::sort(ring.begin(), ring.end());
+
+        for (size_t i=0; i<ring.size(); ++i)
+          queue.push_back(ring[i].second);
+      }
+    }
+    std::reverse(order.begin(), order.end());
+  }
+
+
+  // permuted vertex positions
+  std::vector<int>          rank(nv);
+  std::vector<Mesh::Point>  points(nv);
+  for (size_t i=0; i<nv; ++i)
+  {
+    rank[order[i]] = i;
+    points[i] = mesh_.point(Mesh::VertexHandle(order[i]));
+  }
+
+
+  // faces sorted by their lowest vertex in the new order
+  Mesh::ConstFaceIter        f_it, f_end(mesh_.faces_end());
+  Mesh::ConstFaceVertexIter  fv_it;
+  std::vector<unsigned int>  old_faces, faces;
+  std::vector< std::pair<unsigned int, int> > keys;
+
+  old_faces.reserve(3*nf);
+  keys.reserve(nf);
+  for (f_it=mesh_.faces_begin(); f_it!=f_end; ++f_it)
+  {
+    unsigned int a, b, c;
+    fv_it = mesh_.cfv_iter(f_it);
+    a = rank[fv_it.handle().idx()];  ++fv_it;
+    b = rank[fv_it.handle().idx()];  ++fv_it;
+    c = rank[fv_it.handle().idx()];
+    old_faces.push_back(a);
+    old_faces.push_back(b);
+    old_faces.push_back(c);
+    keys.push_back(std::make_pair(std::min(a, std::min(b, c)), f_it.handle().idx()));
+  }
+  std::sort(keys.begin(), keys.end());
+
+  faces.reserve(3*nf);
+  for (size_t i=0; i<keys.size(); ++i)
+  {
+    int f = keys[i].second;
+    faces.push_back(old_faces[3*f  ]);
+    faces.push_back(old_faces[3*f+1]);
+    faces.push_back(old_faces[3*f+2]);
+  }
+
+
+  // around non-manifold vertices OpenMesh may reject faces in the new
+  // order that it took in the old one, keep the file order then
+  if (!rebuild_mesh(points[0].data(), nv, faces.empty() ? 0 : &faces[0], keys.size()))
+  {
+    std::vector<Mesh::Point>  file_points(nv);
+    for (size_t i=0; i<nv; ++i)
+      file_points[order[i]] = points[i];
+    for (size_t i=0; i<old_faces.size(); ++i)
+      old_faces[i] = order[old_faces[i]];
+
+    rebuild_mesh(file_points[0].data(), nv, old_faces.empty() ? 0 : &old_faces[0], keys.size());
+    std::cerr << "reorder_mesh: faces rejected in the new order, kept the file order\n";
+    return;
+  }
+  vertex_order_.swap(order);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshViewer::
+rebuild_mesh(const float* _points, size_t _n_vertices,
+             const unsigned int* _faces, size_t _n_faces)
+{
+  std::vector<Mesh::VertexHandle>  vhandles(_n_vertices);
+
+  // clear() drops the elements but keeps the properties added by subclasses
+  mesh_.clear();
+  mesh_.reserve(_n_vertices, 3*_n_faces, _n_faces);
+
+  for (size_t i=0; i<_n_vertices; ++i, _points+=3)
+    vhandles[i] = mesh_.add_vertex(Mesh::Point(_points[0], _points[1], _points[2]));
+
+  for (size_t i=0; i<_n_faces; ++i, _faces+=3)
+    mesh_.add_face(vhandles[_faces[0]], vhandles[_faces[1]], vhandles[_faces[2]]);
+
+  return mesh_.n_faces() == _n_faces;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshViewer::
+load_native(const char* _filename)
+{
+  MeshLoader loader;
+
+  if (!MeshLoader::can_read(_filename) || !loader.read(_filename))
+    return false;
+
+  // triangle soups have no shared vertices and thus no 1-rings
+  if (weld_ || loader.is_soup())
+    loader.weld(weld_epsilon_);
+
+  // like the OpenMesh reader, without the faces it rejects
+  if (!rebuild_mesh(loader.points(), loader.n_vertices(),
+                    loader.faces(),  loader.n_faces()))
+    std::cerr << "load_native: dropped " << loader.n_faces() - mesh_.n_faces()
+              << " non-manifold faces\n";
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshViewer::
+cache_key(const char* _filename, uint64_t& _key) const
+{
+  if (!MeshCache::source_key(_filename, _key))
+    return false;
+
+  // everything that changes the loaded vertices or their order
+  uint32_t  epsilon;
+  memcpy(&epsilon, &weld_epsilon_, sizeof(epsilon));
+  _key = _key * 31 + reorder_mode_;
+  _key = _key * 31 + native_loader_;
+  _key = _key * 31 + weld_;
+  _key = _key * 31 + (weld_ ? epsilon : 0);
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+MeshViewer::
+load_cache(const char* _filename)
+{
+  uint64_t  key;
+
+  if (!cache_key(_filename, key) ||
+      !cache_.open(MeshCache::cache_name(_filename).c_str(), key))
+    return false;
+
+  const unsigned int* counts = cache_.section<unsigned int>("counts", 3);
+  if (!counts)
+  {
+    cache_.close();
+    return false;
+  }
+
+  const size_t         nv(counts[0]), ne(counts[1]), nf(counts[2]);
+  const float*         points  = cache_.section<float>("points", 3*nv);
+  const float*         normals = cache_.section<float>("vertex_normals", 3*nv);
+  const unsigned int*  faces   = cache_.section<unsigned int>("faces", 3*nf);
+  const int*           vorder  = cache_.section<int>("vertex_order", nv);
+
+  if (!points || !normals || !faces || !cache_.section<unsigned int>("edges", 2*ne))
+  {
+    cache_.close();
+    return false;
+  }
+
+  // a damaged cache may still have the key of its source
+  for (size_t i=0; i<3*nf; ++i)
+    if (faces[i] >= nv)
+    {
+      cache_.close();
+      return false;
+    }
+
+
+  // the positions are copied from the mapping into OpenMesh; a mesh that
+  // loses faces would not match the cached fields
+  if (!rebuild_mesh(points, nv, faces, nf))
+  {
+    mesh_.clear();
+    cache_.close();
+    return false;
+  }
+
+  Mesh::VertexIter  v_it, v_end(mesh_.vertices_end());
+  for (v_it=mesh_.vertices_begin(); v_it!=v_end; ++v_it, normals+=3)
+    mesh_.set_normal(v_it, Mesh::Normal(normals[0], normals[1], normals[2]));
+
+  if (vorder) vertex_order_.assign(vorder, vorder+nv);
+
+  cache_loaded_ = true;
+  std::cerr << "loaded cache " << MeshCache::cache_name(_filename) << std::endl;
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshViewer::
+save_cache(const char* _filename)
+{
+  const size_t               nv(mesh_.n_vertices()), ne(mesh_.n_edges());
+  MeshCache                  cache;
+  uint64_t                   key;
+  unsigned int               counts[3];
+  std::vector<unsigned int>  edges;
+  Mesh::EdgeIter             e_it, e_end(mesh_.edges_end());
+
+  // the sections would start at &indices_[0] etc. of empty arrays
+  if (nv == 0 || indices_.empty() || !cache_key(_filename, key))
+    return;
+
+  // the file is about to be replaced, drop the old mapping
+  cache_.close();
+
+  counts[0] = nv;
+  counts[1] = ne;
+  counts[2] = indices_.size() / 3;
+
+
+  // edges as vertex pairs, the edge order is not stable across rebuilds
+  edges.reserve(2*ne);
+  for (e_it=mesh_.edges_begin(); e_it!=e_end; ++e_it)
+  {
+    Mesh::HalfedgeHandle h = mesh_.halfedge_handle(e_it.handle(), 0);
+    edges.push_back(mesh_.from_vertex_handle(h).idx());
+    edges.push_back(mesh_.to_vertex_handle(h).idx());
+  }
+
+
+  cache.add_section("counts",            counts, sizeof(counts));
+  cache.add_section("points",            mesh_.points(),         3*nv*sizeof(float));
+  cache.add_section("vertex_normals",    mesh_.vertex_normals(), 3*nv*sizeof(float));
+  cache.add_section("faces",             &indices_[0],           indices_.size()*sizeof(unsigned int));
+  cache.add_section("edges",             &edges[0],              edges.size()*sizeof(unsigned int));
+  if (!vertex_order_.empty())
+    cache.add_section("vertex_order",    &vertex_order_[0],      nv*sizeof(int));
+
+  cache_fields(cache);
+
+  if (!cache.write(MeshCache::cache_name(_filename).c_str(), key))
+    std::cerr << "could not write cache " << MeshCache::cache_name(_filename) << std::endl;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+MeshViewer::
+cached_edges(std::vector<Mesh::EdgeHandle>& _edges) const
+{
+  const unsigned int* counts = cache_.section<unsigned int>("counts", 3);
+  const unsigned int* edges  = counts ? cache_.section<unsigned int>("edges", 2*counts[1]) : 0;
+
+  _edges.clear();
+  if (!edges) return;
+
+  _edges.reserve(counts[1]);
+  for (unsigned int i=0; i<counts[1]; ++i, edges+=2)
+  {
+    Mesh::HalfedgeHandle h = mesh_.find_halfedge(Mesh::VertexHandle(edges[0]),
+                                                 Mesh::VertexHandle(edges[1]));
+    _edges.push_back(h.is_valid() ? mesh_.edge_handle(h) : Mesh::EdgeHandle());
+  }
+}
+
+
+//-----------------------------------------------------------------------------
+
+
 void
 MeshViewer::
 update_face_indices()
@@ -44,6 +44,7 @@
 
 
 #include "GlutExaminer.hh"
+#include "MeshCache.hh"
 #include <OpenMesh/Core/Mesh/TriMesh_ArrayKernelT.hh>
 
 
@@ -53,6 +54,9 @@
 class MeshViewer : public GlutExaminer
 {
 public:
+
+  /// vertex orderings that can be applied after loading
+  enum Reorder_mode { REORDER_NONE, REORDER_MORTON, REORDER_RCM };
    
   /// default constructor
   MeshViewer(const char* _title, int _width, int _height);
@@ -60,6 +64,23 @@ public:
   /// open mesh
   virtual bool open_mesh(const char* _filename);
 
+  /// select the vertex ordering applied by open_mesh()
+  void set_reorder_mode(Reorder_mode _mode) { reorder_mode_ = _mode; }
+
+  /// load from / store to a binary cache next to the source file
+  void set_use_cache(bool _b) { use_cache_ = _b; }
+
+  /// read PLY/OBJ files with the parallel MeshLoader instead of OpenMesh
+  void set_native_loader(bool _b) { native_loader_ = _b; }
+
+  /// read the vertex colors too, through OpenMesh since neither the
+  /// native loader nor the cache keep them
+  void set_read_colors(bool _b) { read_colors_ = _b; }
+
+  /// weld vertices closer than _eps for all formats (STL is always welded),
+  /// _eps <= 0 picks a tolerance relative to the bounding box
+  void set_weld_epsilon(float _eps) { weld_ = true; weld_epsilon_ = _eps; }
+
   /// update buffer with face indices
   void update_face_indices();
 
@@ -69,12 +90,58 @@ public:
 protected:
 
   typedef OpenMesh::TriMesh_ArrayKernelT<>  Mesh;
+
+  /// permute vertices (and faces accordingly) for cache locality
+  void reorder_mesh();
+
+  /// replace the mesh connectivity, keeping all registered properties;
+  /// false if OpenMesh rejected faces, the mesh then lacks them
+  bool rebuild_mesh(const float* _points, size_t _n_vertices,
+                    const unsigned int* _faces, size_t _n_faces);
+
+  /// read _filename with MeshLoader and build the mesh from its arrays
+  bool load_native(const char* _filename);
+
+  /// key of the cache for _filename, depends on the vertex ordering
+  bool cache_key(const char* _filename, uint64_t& _key) const;
+
+  /** rebuild the mesh from an up-to-date cache of _filename. The
+      sections are used in the mapping, but the mesh is still copied
+      into OpenMesh and the fields into the view, so the cache saves
+      parsing, welding and reordering, not the copies. **/
+  bool load_cache(const char* _filename);
+
+  /// write the mesh and the fields added by cache_fields() to the
+  /// cache; an empty mesh is not cached
+  void save_cache(const char* _filename);
+
+  /// register derived fields for save_cache(), data must outlive the call
+  virtual void cache_fields(MeshCache& /*_cache*/) {}
+
+  /// handles of the edges in the order they are stored in cache_
+  void cached_edges(std::vector<Mesh::EdgeHandle>& _edges) const;
+
+  /// index of a vertex in the file it was loaded from
+  int original_index(Mesh::VertexHandle _vh) const
+  { return vertex_order_.empty() ? _vh.idx() : vertex_order_[_vh.idx()]; }
   
 
 protected:
 
   Mesh                       mesh_;
   std::vector<unsigned int>  indices_;
+
+  Reorder_mode               reorder_mode_;
+  std::vector<int>           vertex_order_;  // new index -> original index
+
+  bool                       native_loader_;
+  bool                       read_colors_;
+  bool                       colors_loaded_; // mesh_ has the colors of the file
+  bool                       weld_;
+  float                      weld_epsilon_;
+  bool                       use_cache_;
+  bool                       cache_loaded_;  // mesh_ was rebuilt from cache_
+  MeshCache                  cache_;
 };
 
 
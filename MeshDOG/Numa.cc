@@ -0,0 +1,216 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS Numa - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "Numa.hh"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+bool Numa::serial_touch_ = false;
+
+
+// cpus of NUMA node _node from sysfs, e.g. "0-15,32-47"
+static bool node_cpus(unsigned int _node, std::vector<int>& _cpus)
+{
+  char name[128];
+  snprintf(name, sizeof(name), "/sys/devices/system/node/node%u/cpulist", _node);
+
+  std::ifstream  in(name);
+  int            first, last;
+  char           sep;
+
+  _cpus.clear();
+  if (!in) return false;
+  while (in >> first)
+  {
+    last = first;
+    if (in.peek() == '-')
+      in >> sep >> last;
+    for (int c=first; c<=last; ++c)
+      _cpus.push_back(c);
+    if (in.peek() == ',')
+      in >> sep;
+  }
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+unsigned int
+Numa::
+n_nodes()
+{
+  std::vector<int> cpus;
+  unsigned int     n(0);
+
+  while (node_cpus(n, cpus))
+    ++n;
+  return n ? n : 1;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+Numa::
+bind_to_node(unsigned int _node)
+{
+#if defined(__linux__)
+  std::vector<int>  cpus;
+  cpu_set_t         set;
+
+  if (!node_cpus(_node, cpus) || cpus.empty())
+    return false;
+
+  CPU_ZERO(&set);
+  for (size_t i=0; i<cpus.size(); ++i)
+    if (cpus[i] < CPU_SETSIZE)
+      CPU_SET(cpus[i], &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+Numa::
+pin_threads(Pin_mode _mode)
+{
+  if (_mode == PIN_NONE) return true;
+
+#if defined(__linux__)
+  cpu_set_t                        allowed;
+  std::vector<int>                 cpus, order;
+  std::vector< std::vector<int> >  nodes;
+
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    return false;
+
+
+  // the allowed cpus per node, a single node without sysfs
+  while (node_cpus(nodes.size(), cpus))
+  {
+    nodes.push_back(std::vector<int>());
+    for (size_t i=0; i<cpus.size(); ++i)
+      if (cpus[i] < CPU_SETSIZE && CPU_ISSET(cpus[i], &allowed))
+        nodes.back().push_back(cpus[i]);
+  }
+  if (nodes.empty())
+  {
+    nodes.push_back(std::vector<int>());
+    for (int c=0; c<CPU_SETSIZE; ++c)
+      if (CPU_ISSET(c, &allowed))
+        nodes.back().push_back(c);
+  }
+
+  if (_mode == PIN_CLOSE)
+    for (size_t n=0; n<nodes.size(); ++n)
+      order.insert(order.end(), nodes[n].begin(), nodes[n].end());
+  else
+  {
+    size_t longest(0);
+    for (size_t n=0; n<nodes.size(); ++n)
+      longest = std::max(longest, nodes[n].size());
+    for (size_t i=0; i<longest; ++i)
+      for (size_t n=0; n<nodes.size(); ++n)
+        if (i < nodes[n].size())
+          order.push_back(nodes[n][i]);
+  }
+  if (order.empty()) return false;
+
+
+  // every thread binds itself
+  int failed(0);
+#pragma omp parallel reduction(+:failed)
+  {
+    int thread(0);
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(order[thread % order.size()], &set);
+    failed += (sched_setaffinity(0, sizeof(set), &set) != 0);
+  }
+
+  std::cerr << "pinned threads to " << order.size() << " cpus on "
+            << nodes.size() << " nodes\n";
+  return failed == 0;
+#else
+  std::cerr << "thread pinning is not supported on this system\n";
+  return false;
+#endif
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+Numa::
+first_touch(void* _data, size_t _bytes)
+{
+  const long long  page(4096), n_pages((_bytes + page - 1) / page);
+  char*            data((char*)_data);
+
+#pragma omp parallel for schedule(static) if (n_pages > 16 && !serial_touch_)
+  for (long long i=0; i<n_pages; ++i)
+    data[i*page] = 0;
+}
+
+
+//=============================================================================
@@ -0,0 +1,142 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS Numa
+//
+//=============================================================================
+
+
+#ifndef NUMA_HH
+#define NUMA_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include "HugePageArena.hh"
+#include <new>
+#include <stddef.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class Numa Numa.hh
+    Thread pinning and first-touch page placement.
+
+    Linux places a page on the NUMA node of the thread that writes it
+    first. Arrays from FirstTouchAllocator are touched by the OpenMP
+    threads with a static schedule, so a kernel with the same schedule
+    (MeshKernel) finds each thread's part of the array on its own node.
+    This only holds while the threads stay where they are, see
+    pin_threads(). Task loops (MeshView) take chunks in any order, for
+    them the pages are only spread over the nodes, not matched.
+**/
+
+class Numa
+{
+public:
+
+  /// how the OpenMP threads are bound to cpus
+  enum Pin_mode { PIN_NONE, PIN_CLOSE, PIN_SPREAD };
+
+  /// bind thread i to one cpu: PIN_CLOSE fills a node before the next
+  /// one, PIN_SPREAD alternates between the nodes (Linux only)
+  static bool pin_threads(Pin_mode _mode);
+
+  /// bind the calling thread to the cpus of one node (Linux only)
+  static bool bind_to_node(unsigned int _node);
+
+  /// number of NUMA nodes, 1 where this is unknown
+  static unsigned int n_nodes();
+
+  /// write every page of [_data, _data+_bytes) from the thread that
+  /// processes it in a static schedule
+  static void first_touch(void* _data, size_t _bytes);
+
+  /// touch from the calling thread only, for a process forked from one
+  /// that ran OpenMP: its thread pool is gone and a new team can hang
+  static void set_serial_touch() { serial_touch_ = true; }
+
+
+private:
+
+  static bool serial_touch_;
+};
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class FirstTouchAllocator Numa.hh
+    std::vector allocator placing pages by Numa::first_touch().
+
+    Elements are default initialized, so resize() leaves them to the
+    kernel that fills them instead of zeroing from the calling thread.
+    The memory comes from HugePageArena.
+**/
+
+template <class T>
+class FirstTouchAllocator
+{
+public:
+
+  typedef T value_type;
+
+  FirstTouchAllocator() {}
+  template <class U> FirstTouchAllocator(const FirstTouchAllocator<U>&) {}
+
+  T* allocate(size_t _n)
+  {
+    size_t  bytes(_n*sizeof(T));
+    void*   data(HugePageArena::allocate(bytes));
+    if (!data)
+      throw std::bad_alloc();
+    Numa::first_touch(data, bytes);
+    return (T*)data;
+  }
+
+  void deallocate(T* _data, size_t _n) { HugePageArena::release(_data, _n*sizeof(T)); }
+
+  template <class U> void construct(U* _p) { ::new((void*)_p) U; }
+  template <class U, class... Args> void construct(U* _p, Args&&... _args)
+  { ::new((void*)_p) U(static_cast<Args&&>(_args)...); }
+
+  template <class U> struct rebind { typedef FirstTouchAllocator<U> other; };
+};
+
+template <class T, class U>
+bool operator==(const FirstTouchAllocator<T>&, const FirstTouchAllocator<U>&) { return true; }
+template <class T, class U>
+bool operator!=(const FirstTouchAllocator<T>&, const FirstTouchAllocator<U>&) { return false; }
+
+
+//=============================================================================
+#endif // NUMA_HH defined
+//=============================================================================
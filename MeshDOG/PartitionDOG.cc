@@ -0,0 +1,505 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS PartitionDOG - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "PartitionDOG.hh"
+#include "MeshKernel.hh"
+#include "Numa.hh"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <new>
+#include <float.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+/// bins of the DoG histograms
+static const size_t n_bins = 65536;
+
+
+/// histogram bin of a DoG value, the same in the workers and the parent
+static inline size_t bin_of(float _value, float _vmin, double _scale)
+{
+  return (size_t)((_value - _vmin) * _scale);
+}
+
+
+/// arrays of the shared memory segment
+struct PartitionDOG::Shared
+{
+  struct Control
+  {
+    std::atomic<unsigned int>  count, generation, failed;
+  };
+
+  struct Slot
+  {
+    float         vmin, vmax;
+    unsigned int  n_halo;
+  };
+
+  Control*       control;
+  float*         exchange[2];  // boundary values by vertex, one per parity
+  float*         dog;          // final DoG values by vertex
+  Slot*          slots;        // one per worker
+  unsigned int*  histograms;   // n_bins per worker
+  unsigned int   n_workers;
+
+  /// wait for all workers, false if one of them failed
+  bool barrier()
+  {
+    const unsigned int generation = control->generation.load();
+
+    if (control->count.fetch_add(1) + 1 == n_workers)
+    {
+      control->count.store(0);
+      control->generation.fetch_add(1);
+    }
+    else
+      while (control->generation.load() == generation && !control->failed.load())
+        sched_yield();
+
+    return !control->failed.load();
+  }
+};
+
+
+//-----------------------------------------------------------------------------
+
+
+PartitionDOG::
+PartitionDOG()
+  : iters_(10), fraction_(0.95), n_processes_(2)
+{
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+static void
+breadth_first(unsigned int _start,
+              const std::vector<unsigned int>& _offsets,
+              const std::vector<unsigned int>& _adjacency,
+              std::vector<char>& _visited, std::vector<unsigned int>& _order)
+{
+  size_t head = _order.size();
+
+  _visited[_start] = 1;
+  _order.push_back(_start);
+  for (; head < _order.size(); ++head)
+  {
+    const unsigned int v = _order[head];
+    for (unsigned int i=_offsets[v]; i<_offsets[v+1]; ++i)
+      if (!_visited[_adjacency[i]])
+      {
+        _visited[_adjacency[i]] = 1;
+        _order.push_back(_adjacency[i]);
+      }
+  }
+}
+
+
+void
+PartitionDOG::
+partition(size_t _n_vertices,
+          const unsigned int* _faces, size_t _n_faces,
+          unsigned int _n_parts, std::vector<unsigned int>& _part)
+{
+  const size_t               nv(_n_vertices);
+  std::vector<unsigned int>  offsets(nv+1, 0), adjacency, fill, order;
+  std::vector<char>          visited(nv, 0);
+
+
+  // vertex graph, duplicate edges do not matter for the traversal
+  for (size_t i=0; i<3*_n_faces; ++i)
+    offsets[_faces[i]+1] += 2;
+  for (size_t v=0; v<nv; ++v)
+    offsets[v+1] += offsets[v];
+
+  adjacency.resize(offsets[nv]);
+  fill.assign(offsets.begin(), offsets.end()-1);
+  for (size_t f=0; f<_n_faces; ++f)
+  {
+    const unsigned int* t = _faces + 3*f;
+    for (int i=0; i<3; ++i)
+    {
+      adjacency[fill[t[i]]++] = t[(i+1)%3];
+      adjacency[fill[t[i]]++] = t[(i+2)%3];
+    }
+  }
+
+
+  // per component: the last vertex reached from an arbitrary one is
+  // (nearly) peripheral, its level structure gives thin cuts
+  order.reserve(nv);
+  for (size_t s=0; s<nv; ++s)
+  {
+    if (visited[s]) continue;
+
+    const size_t begin = order.size();
+    breadth_first(s, offsets, adjacency, visited, order);
+
+    const unsigned int start = order.back();
+    for (size_t i=begin; i<order.size(); ++i)
+      visited[order[i]] = 0;
+    order.resize(begin);
+    breadth_first(start, offsets, adjacency, visited, order);
+  }
+
+  _part.resize(nv);
+  for (size_t i=0; i<nv; ++i)
+    _part[order[i]] = (unsigned int)((unsigned long long)i * _n_parts / nv);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+PartitionDOG::
+detect(const float* _points, size_t _n_vertices,
+       const unsigned int* _faces, size_t _n_faces,
+       std::vector<unsigned int>& _features)
+{
+  const size_t               nv(_n_vertices);
+  std::vector<unsigned int>  part;
+  std::vector<pid_t>         workers;
+  Shared                     shared;
+  bool                       ok(true);
+
+  _features.clear();
+  if (nv == 0) return true;
+
+  const unsigned int n = std::max(1, std::min(n_processes_, (int)std::min(nv, (size_t)1024)));
+  partition(nv, _faces, _n_faces, n, part);
+
+
+  // one segment: control block, two exchange buffers, DoG values,
+  // worker slots and histograms, every array on its own cache line
+  size_t  offsets[7], size(0);
+  size_t  sizes[6] = { sizeof(Shared::Control), nv*sizeof(float), nv*sizeof(float),
+                       nv*sizeof(float), n*sizeof(Shared::Slot), n*n_bins*sizeof(unsigned int) };
+  for (int i=0; i<6; ++i)
+  {
+    offsets[i] = size;
+    size = (size + sizes[i] + 63) & ~(size_t)63;
+  }
+
+  char name[64];
+  snprintf(name, sizeof(name), "/meshdog.%d", (int)getpid());
+
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0)
+  {
+    perror("shm_open");
+    return false;
+  }
+  shm_unlink(name);  // the workers inherit the mapping
+
+  void* data = MAP_FAILED;
+  if (ftruncate(fd, size) == 0)
+    data = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    perror("mmap");
+    return false;
+  }
+
+  char* base = (char*)data;
+  shared.control    = new (base + offsets[0]) Shared::Control;
+  shared.exchange[0] = (float*)(base + offsets[1]);
+  shared.exchange[1] = (float*)(base + offsets[2]);
+  shared.dog        = (float*)(base + offsets[3]);
+  shared.slots      = (Shared::Slot*)(base + offsets[4]);
+  shared.histograms = (unsigned int*)(base + offsets[5]);
+  shared.n_workers  = n;
+  shared.control->count = 0;
+  shared.control->generation = 0;
+  shared.control->failed = 0;
+
+
+  // the workers are forked without running OpenMP in them, the kernels
+  // are called vertex by vertex and the arrays touched serially
+  std::cout.flush();
+  std::cerr.flush();
+  for (unsigned int p=0; p<n; ++p)
+  {
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      bool worker_ok(false);
+      Numa::set_serial_touch();
+      try
+      {
+        worker_ok = run_worker(p, shared, _points, nv, _faces, _n_faces, part);
+      }
+      catch (...) {}
+      if (!worker_ok) shared.control->failed = 1;
+      _exit(worker_ok ? 0 : 1);
+    }
+    if (pid < 0)
+    {
+      perror("fork");
+      shared.control->failed = 1;
+      ok = false;
+      break;
+    }
+    workers.push_back(pid);
+  }
+
+  for (size_t i=0; i<workers.size(); )
+  {
+    int status;
+    if (waitpid(-1, &status, 0) < 0)
+    {
+      if (errno == EINTR) continue;
+      ok = false;
+      break;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+      shared.control->failed = 1;
+      ok = false;
+    }
+    ++i;
+  }
+
+
+  // global threshold: reduce the ranges and histograms of the workers,
+  // then select inside the bin holding the threshold
+  if (ok)
+  {
+    const size_t  k = std::min(nv-1, (size_t)(nv * fraction_));
+    float         vmin(FLT_MAX), vmax(-FLT_MAX), threshold;
+    size_t        n_halo(0);
+
+    for (unsigned int p=0; p<n; ++p)
+    {
+      vmin = std::min(vmin, shared.slots[p].vmin);
+      vmax = std::max(vmax, shared.slots[p].vmax);
+      n_halo += shared.slots[p].n_halo;
+    }
+
+    if (!(vmax > vmin))
+      threshold = vmin;
+    else
+    {
+      const double         scale = (n_bins - 1) / (double(vmax) - vmin);
+      std::vector<size_t>  histogram(n_bins, 0);
+      std::vector<float>   candidates;
+      size_t               bin(0), below(0);
+
+      for (unsigned int p=0; p<n; ++p)
+        for (size_t b=0; b<n_bins; ++b)
+          histogram[b] += shared.histograms[p*n_bins + b];
+
+      while (below + histogram[bin] <= k)
+        below += histogram[bin++];
+
+      candidates.reserve(histogram[bin]);
+      for (size_t v=0; v<nv; ++v)
+        if (bin_of(shared.dog[v], vmin, scale) == bin)
+          candidates.push_back(shared.dog[v]);
+
+      std::nth_element(candidates.begin(), candidates.begin() + (k - below), candidates.end());
+      threshold = candidates[k - below];
+    }
+
+    std::vector<char> used(nv, 0);
+    for (size_t i=0; i<3*_n_faces; ++i)
+      used[_faces[i]] = 1;
+
+    for (size_t v=0; v<nv; ++v)
+      if (used[v] && shared.dog[v] >= threshold)
+        _features.push_back(v);
+
+    std::cerr << n << " processes, " << n_halo << " halo vertices, "
+              << _features.size() << " features\n";
+  }
+
+  munmap(data, size);
+  return ok;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+PartitionDOG::
+run_worker(unsigned int _p, Shared& _shared,
+           const float* _points, size_t _n_vertices,
+           const unsigned int* _faces, size_t _n_faces,
+           const std::vector<unsigned int>& _part)
+{
+  std::vector<unsigned int>  local, local_faces, mine, send, recv;
+  std::vector<float>         local_points, f, eavg, dog;
+  MeshKernel                 kernel;
+
+
+  // spread the workers over the NUMA nodes, everything below is then
+  // allocated on the node of the worker
+  Numa::bind_to_node(_p % Numa::n_nodes());
+
+
+  // the faces touching the part, their vertices are the part and its
+  // 1-ring halo; local ids follow the global order like the rings do
+  for (size_t i=0; i<_n_faces; ++i)
+  {
+    const unsigned int* t = _faces + 3*i;
+    if (_part[t[0]] == _p || _part[t[1]] == _p || _part[t[2]] == _p)
+      local_faces.insert(local_faces.end(), t, t+3);
+  }
+
+  local = local_faces;
+  for (size_t v=0; v<_n_vertices; ++v)
+    if (_part[v] == _p)
+      local.push_back(v);
+  std::sort(local.begin(), local.end());
+  local.erase(std::unique(local.begin(), local.end()), local.end());
+
+  for (size_t i=0; i<local_faces.size(); ++i)
+    local_faces[i] = std::lower_bound(local.begin(), local.end(), local_faces[i]) - local.begin();
+
+  local_points.resize(3*local.size());
+  for (size_t i=0; i<local.size(); ++i)
+  {
+    std::copy(_points + 3*local[i], _points + 3*local[i] + 3, &local_points[3*i]);
+    if (_part[local[i]] == _p)
+      mine.push_back(i);
+  }
+
+
+  // a face with vertices of two parts puts its own vertices into the
+  // halo of the other part and the other ones into this halo
+  for (size_t i=0; i<local_faces.size(); i+=3)
+  {
+    bool is_mine[3], mixed(false);
+    for (int j=0; j<3; ++j)
+    {
+      is_mine[j] = (_part[local[local_faces[i+j]]] == _p);
+      mixed |= (is_mine[j] != is_mine[0]);
+    }
+    if (mixed)
+      for (int j=0; j<3; ++j)
+        (is_mine[j] ? send : recv).push_back(local_faces[i+j]);
+  }
+  std::sort(send.begin(), send.end());
+  send.erase(std::unique(send.begin(), send.end()), send.end());
+  std::sort(recv.begin(), recv.end());
+  recv.erase(std::unique(recv.begin(), recv.end()), recv.end());
+
+  kernel.set_mesh(local_points.empty() ? 0 : &local_points[0], local.size(),
+                  local_faces.empty() ? 0 : &local_faces[0], local_faces.size() / 3);
+
+
+  // curvature and Jacobi convolutions of the own vertices, the halo is
+  // refreshed from the other parts before every step
+  f.assign(local.size(), 0.0f);
+  eavg.assign(local.size(), 0.0f);
+  dog.assign(local.size(), 0.0f);
+  for (size_t i=0; i<mine.size(); ++i)
+  {
+    f[mine[i]]    = kernel.uniform_mean_curvature(mine[i]);
+    eavg[mine[i]] = kernel.edge_average(mine[i]);
+  }
+
+  for (int iter=0; iter<iters_; ++iter)
+  {
+    float* buffer = _shared.exchange[iter & 1];
+
+    for (size_t i=0; i<send.size(); ++i)
+      buffer[local[send[i]]] = f[send[i]];
+    if (!_shared.barrier()) return false;
+    for (size_t i=0; i<recv.size(); ++i)
+      f[recv[i]] = buffer[local[recv[i]]];
+
+    for (size_t i=0; i<mine.size(); ++i)
+    {
+      const unsigned int v = mine[i];
+      dog[v] = kernel.valence(v) ? kernel.gaussian_conv(v, &f[0], eavg[v]) - f[v] : 0.0f;
+    }
+    for (size_t i=0; i<mine.size(); ++i)
+      f[mine[i]] += dog[mine[i]];
+  }
+
+
+  // publish the DoG values, then the histogram over the global range
+  Shared::Slot& slot = _shared.slots[_p];
+  slot.vmin   =  FLT_MAX;
+  slot.vmax   = -FLT_MAX;
+  slot.n_halo = recv.size();
+  for (size_t i=0; i<mine.size(); ++i)
+  {
+    const float d = isnan(dog[mine[i]]) ? 0.0f : dog[mine[i]];
+    _shared.dog[local[mine[i]]] = d;
+    slot.vmin = std::min(slot.vmin, d);
+    slot.vmax = std::max(slot.vmax, d);
+  }
+  if (!_shared.barrier()) return false;
+
+  float vmin(FLT_MAX), vmax(-FLT_MAX);
+  for (unsigned int p=0; p<_shared.n_workers; ++p)
+  {
+    vmin = std::min(vmin, _shared.slots[p].vmin);
+    vmax = std::max(vmax, _shared.slots[p].vmax);
+  }
+
+  if (vmax > vmin)
+  {
+    const double   scale = (n_bins - 1) / (double(vmax) - vmin);
+    unsigned int*  histogram = _shared.histograms + _p*n_bins;
+
+    for (size_t i=0; i<mine.size(); ++i)
+      ++histogram[bin_of(_shared.dog[local[mine[i]]], vmin, scale)];
+  }
+  return true;
+}
+
+
+//=============================================================================
@@ -0,0 +1,108 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS PartitionDOG
+//
+//=============================================================================
+
+
+#ifndef PARTITION_DOG_HH
+#define PARTITION_DOG_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include <vector>
+#include <stddef.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class PartitionDOG PartitionDOG.hh
+    MeshDOG detection in several worker processes.
+
+    The vertex graph is cut into parts along a breadth-first level
+    structure. Every worker process builds a MeshKernel of its part plus
+    the 1-ring halo in its own memory and runs the Jacobi convolutions
+    on the vertices it owns. After each step the boundary values are
+    published in a POSIX shared memory segment and the halo values are
+    read back from it. The threshold comes from the per-worker DoG
+    histograms, so the features are the same as those of a MeshKernel
+    run on the whole mesh, see tests/regression.cc.
+**/
+
+class PartitionDOG
+{
+public:
+
+  PartitionDOG();
+
+  /// number of Gaussian convolutions
+  void set_iterations(int _iters) { iters_ = _iters; }
+
+  /// fraction of vertices below the DoG threshold
+  void set_fraction(double _fraction) { fraction_ = _fraction; }
+
+  /// number of worker processes
+  void set_processes(int _n) { n_processes_ = _n; }
+
+  /// detect the features of a mesh, _features receives vertex indices
+  bool detect(const float* _points, size_t _n_vertices,
+              const unsigned int* _faces, size_t _n_faces,
+              std::vector<unsigned int>& _features);
+
+
+  /// split the vertices into _n_parts parts of equal size along a
+  /// breadth-first order started at a pseudo-peripheral vertex
+  static void partition(size_t _n_vertices,
+                        const unsigned int* _faces, size_t _n_faces,
+                        unsigned int _n_parts, std::vector<unsigned int>& _part);
+
+
+private:
+
+  struct Shared;
+
+  /// convolutions and histogram of part _p, runs in a worker process
+  bool run_worker(unsigned int _p, Shared& _shared,
+                  const float* _points, size_t _n_vertices,
+                  const unsigned int* _faces, size_t _n_faces,
+                  const std::vector<unsigned int>& _part);
+
+  int     iters_;
+  double  fraction_;
+  int     n_processes_;
+};
+
+
+//=============================================================================
+#endif // PARTITION_DOG_HH defined
+//=============================================================================
@@ -0,0 +1,311 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS PatchDOG - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "PatchDOG.hh"
+#include "MeshKernel.hh"
+#include "HugePageArena.hh"
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include <math.h>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+namespace {
+
+// orders vertex ids by one coordinate
+struct Along
+{
+  Along(const float* _points, int _axis) : points(_points), axis(_axis) {}
+  bool operator()(unsigned int _a, unsigned int _b) const
+  { return points[3*_a+axis] < points[3*_b+axis]; }
+  const float* points;
+  int          axis;
+};
+
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+PatchDOG::
+PatchDOG()
+  : iters_(10), fraction_(0.95), patch_size_(1000000), max_patch_vertices_(0)
+{
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+PatchDOG::
+detect(const float* _points, size_t _n_vertices,
+       const unsigned int* _faces, size_t _n_faces,
+       std::vector<unsigned int>& _features)
+{
+  const size_t  nv(_n_vertices), nf(_n_faces);
+  float         bbmin[3], bbmax[3];
+
+  _features.clear();
+  max_patch_vertices_ = 0;
+  if (nv == 0) return true;
+
+
+  // halve the vertices at the median of the longest side of their box
+  // until at most patch_size_ are left; a grid would leave most of its
+  // cells empty on a surface and overfill the others. Left halves are
+  // split first, so the patches end up in order in patch_vertices
+  const size_t               patch_size = std::max<size_t>(patch_size_, 1);
+  std::vector<unsigned int>  cell_offsets(1, 0);
+  std::vector<std::pair<unsigned int, unsigned int> >  ranges(1, std::make_pair(0u, (unsigned int)nv));
+  MappedArray<unsigned int>  patch_vertices;
+
+  if (!patch_vertices.resize(nv))
+    return false;
+  for (size_t v=0; v<nv; ++v)
+    patch_vertices[v] = v;
+
+  while (!ranges.empty())
+  {
+    const unsigned int  b(ranges.back().first), e(ranges.back().second);
+    ranges.pop_back();
+
+    if (e - b <= patch_size)
+    {
+      cell_offsets.push_back(e);
+      continue;
+    }
+
+    for (int k=0; k<3; ++k)
+      bbmin[k] = bbmax[k] = _points[3*patch_vertices[b]+k];
+    for (unsigned int i=b; i<e; ++i)
+      for (int k=0; k<3; ++k)
+      {
+        bbmin[k] = std::min(bbmin[k], _points[3*patch_vertices[i]+k]);
+        bbmax[k] = std::max(bbmax[k], _points[3*patch_vertices[i]+k]);
+      }
+
+    int axis(0);
+    for (int k=1; k<3; ++k)
+      if (bbmax[k] - bbmin[k] > bbmax[axis] - bbmin[axis])
+        axis = k;
+
+    const unsigned int  m(b + (e - b) / 2);
+    std::nth_element(patch_vertices.data() + b, patch_vertices.data() + m,
+                     patch_vertices.data() + e, Along(_points, axis));
+    ranges.push_back(std::make_pair(m, e));
+    ranges.push_back(std::make_pair(b, m));
+  }
+
+  const int  n_patches = cell_offsets.size() - 1;
+
+
+  // vertex -> face incidences
+  MappedArray<unsigned int> vf_offsets, vf_faces;
+  if (!vf_offsets.resize(nv+1) || !vf_faces.resize(3*nf))
+    return false;
+
+  for (size_t i=0; i<3*nf; ++i)
+    ++vf_offsets[_faces[i]+1];
+  for (size_t v=0; v<nv; ++v)
+    vf_offsets[v+1] += vf_offsets[v];
+  {
+    MappedArray<unsigned int> fill;
+    if (!fill.resize(nv)) return false;
+    for (size_t f=0; f<nf; ++f)
+      for (int i=0; i<3; ++i)
+      {
+        unsigned int v = _faces[3*f+i];
+        vf_faces[vf_offsets[v] + fill[v]++] = f;
+      }
+  }
+
+
+  // stream the patches
+  MappedArray<float>  dog;
+  if (!dog.resize(nv)) return false;
+
+  std::unordered_map<unsigned int, int>  level;
+  std::vector<unsigned int>              frontier, next, local, patch_faces, local_faces;
+  std::vector<float>                     local_points;
+  MeshKernel::Field                      curv, eavg, f, local_dog;
+  MeshKernel                             kernel;
+  bool                                   sampled(false);
+
+  for (int p=0; p<n_patches; ++p)
+  {
+    if (cell_offsets[p] == cell_offsets[p+1]) continue;
+
+    // grow the patch by iters_ rings
+    level.clear();
+    frontier.assign(patch_vertices.data() + cell_offsets[p],
+                    patch_vertices.data() + cell_offsets[p+1]);
+    for (size_t i=0; i<frontier.size(); ++i)
+      level[frontier[i]] = 0;
+
+    for (int r=1; r<=iters_ && !frontier.empty(); ++r)
+    {
+      next.clear();
+      for (size_t i=0; i<frontier.size(); ++i)
+        for (unsigned int j=vf_offsets[frontier[i]]; j<vf_offsets[frontier[i]+1]; ++j)
+          for (int k=0; k<3; ++k)
+          {
+            unsigned int w = _faces[3*vf_faces[j]+k];
+            if (level.insert(std::make_pair(w, r)).second)
+              next.push_back(w);
+          }
+      frontier.swap(next);
+    }
+
+
+    // all faces around the grown patch, so its vertices have full 1-rings
+    patch_faces.clear();
+    local.clear();
+    for (std::unordered_map<unsigned int, int>::const_iterator it=level.begin(); it!=level.end(); ++it)
+    {
+      local.push_back(it->first);
+      for (unsigned int j=vf_offsets[it->first]; j<vf_offsets[it->first+1]; ++j)
+        patch_faces.push_back(vf_faces[j]);
+    }
+    std::sort(patch_faces.begin(), patch_faces.end());
+    patch_faces.erase(std::unique(patch_faces.begin(), patch_faces.end()), patch_faces.end());
+
+    for (size_t i=0; i<patch_faces.size(); ++i)
+      for (int k=0; k<3; ++k)
+        local.push_back(_faces[3*patch_faces[i]+k]);
+
+    // local indices increase with the global ones, keeping the ring order
+    std::sort(local.begin(), local.end());
+    local.erase(std::unique(local.begin(), local.end()), local.end());
+    max_patch_vertices_ = std::max(max_patch_vertices_, local.size());
+
+    local_points.resize(3*local.size());
+    for (size_t i=0; i<local.size(); ++i)
+      for (int k=0; k<3; ++k)
+        local_points[3*i+k] = _points[3*local[i]+k];
+
+    local_faces.resize(3*patch_faces.size());
+    for (size_t i=0; i<patch_faces.size(); ++i)
+      for (int k=0; k<3; ++k)
+        local_faces[3*i+k] = std::lower_bound(local.begin(), local.end(),
+                                              _faces[3*patch_faces[i]+k]) - local.begin();
+
+
+    // curvature + DoG on the patch, keep the values of its own vertices
+    kernel.set_mesh(&local_points[0], local.size(),
+                    local_faces.empty() ? 0 : &local_faces[0], patch_faces.size());
+    kernel.calc_uniform_mean_curvature(curv);
+    kernel.calc_edge_average(eavg);
+    f = curv;
+    kernel.detect_meshdog(iters_, eavg, f, local_dog);
+
+    for (unsigned int i=cell_offsets[p]; i<cell_offsets[p+1]; ++i)
+    {
+      unsigned int v = patch_vertices[i];
+      float d = local_dog[std::lower_bound(local.begin(), local.end(), v) - local.begin()];
+      dog[v] = isnan(d) ? 0.0f : d;
+    }
+
+    // the kernel arrays are reused by all patches, look up their huge
+    // pages once while they are touched
+    if (!sampled)
+    {
+      HugePageArena::sample();
+      sampled = true;
+    }
+  }
+
+
+  // global threshold and features
+  const float threshold = select(dog, std::min(nv-1, (size_t)(nv * fraction_)));
+
+  for (size_t v=0; v<nv; ++v)
+    if (vf_offsets[v] != vf_offsets[v+1] && dog[v] >= threshold)
+      _features.push_back(v);
+
+  std::cerr << n_patches << " patches, at most " << max_patch_vertices_
+            << " vertices each, " << _features.size() << " features\n";
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+float
+PatchDOG::
+select(const MappedArray<float>& _values, size_t _k)
+{
+  const size_t  n(_values.size()), n_bins(65536);
+  float         vmin(_values[0]), vmax(_values[0]);
+
+  for (size_t i=1; i<n; ++i)
+  {
+    vmin = std::min(vmin, _values[i]);
+    vmax = std::max(vmax, _values[i]);
+  }
+  if (!(vmax > vmin)) return vmin;
+
+
+  // count values per bin, find the bin holding the _k-th value and
+  // select inside it
+  const double           scale = (n_bins - 1) / (double(vmax) - vmin);
+  std::vector<size_t>    histogram(n_bins, 0);
+  std::vector<float>     candidates;
+  size_t                 bin(0), below(0);
+
+  for (size_t i=0; i<n; ++i)
+    ++histogram[(size_t)((_values[i] - vmin) * scale)];
+
+  while (below + histogram[bin] <= _k)
+    below += histogram[bin++];
+
+  candidates.reserve(histogram[bin]);
+  for (size_t i=0; i<n; ++i)
+    if ((size_t)((_values[i] - vmin) * scale) == bin)
+      candidates.push_back(_values[i]);
+
+  std::nth_element(candidates.begin(), candidates.begin() + (_k - below), candidates.end());
+  return candidates[_k - below];
+}
+
+
+//=============================================================================
@@ -0,0 +1,107 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS PatchDOG
+//
+//=============================================================================
+
+
+#ifndef PATCH_DOG_HH
+#define PATCH_DOG_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include "MappedArray.hh"
+#include <vector>
+#include <stddef.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class PatchDOG PatchDOG.hh
+    Out-of-core MeshDOG detection.
+
+    The vertices are split into patches by halving them at the median of
+    the longest side of their bounding box. Every patch is grown by as
+    many rings as there are convolution steps, processed with MeshKernel,
+    and only the DoG values of its own vertices are kept. The features are
+    the same as those of a MeshKernel run on the whole mesh, see
+    tests/regression.cc.
+
+    The mesh sized work arrays (patch lists, incidences, DoG values) are
+    MappedArray's the kernel can page out, and the per-patch arrays grow
+    with the patch and its halo only. The input points and faces are
+    read in place: they stay resident unless the caller maps them, so
+    they bound the memory from below. smoother -outofcore reads them
+    with MeshLoader, only binary PLY positions stay in the mapping.
+**/
+
+class PatchDOG
+{
+public:
+
+  PatchDOG();
+
+  /// number of Gaussian convolutions, also the halo width in rings
+  void set_iterations(int _iters) { iters_ = _iters; }
+
+  /// fraction of vertices below the DoG threshold
+  void set_fraction(double _fraction) { fraction_ = _fraction; }
+
+  /// largest number of vertices per patch, without the halo
+  void set_patch_size(size_t _n) { patch_size_ = _n; }
+
+  /// detect the features of a mesh, _features receives vertex indices
+  bool detect(const float* _points, size_t _n_vertices,
+              const unsigned int* _faces, size_t _n_faces,
+              std::vector<unsigned int>& _features);
+
+  /// largest number of vertices of a processed patch, halo included
+  size_t max_patch_vertices() const { return max_patch_vertices_; }
+
+
+private:
+
+  /// _k-th smallest value, found by histogram refinement instead of a sort
+  static float select(const MappedArray<float>& _values, size_t _k);
+
+  int     iters_;
+  double  fraction_;
+  size_t  patch_size_;
+  size_t  max_patch_vertices_;
+};
+
+
+//=============================================================================
+#endif // PATCH_DOG_HH defined
+//=============================================================================
+
@@ -39,10 +39,15 @@
 //== INCLUDES =================================================================
 
 #include "QualityViewer.hh"
+#include "FeatureGrid.hh"
+#include "HugePageArena.hh"
 #include <vector>
 #include <float.h>
 #include <math.h>
 #include <algorithm>
+#include <limits>
+#include <fstream>
+#include <chrono>
 
 #include <OpenMesh/Core/IO/MeshIO.hh>
 //== IMPLEMENTATION ========================================================== 
@@ -52,13 +57,6 @@ QualityViewer::QualityViewer(const char* _title, int _width, int _height)
 { 
     mesh_.request_vertex_colors();
 
-    mesh_.add_property(vcurvature_);
-    mesh_.add_property(vunicurvature_);
-    mesh_.add_property(vweight_);
-    mesh_.add_property(eweight_);
-    mesh_.add_property(tshape_);
-    mesh_.add_property(vgausscurvature_);
-
     add_draw_mode("Uniform Mean Curvature");
     add_draw_mode("Mean Curvature");
     add_draw_mode("Gaussian Curvature");
@@ -73,15 +71,23 @@ QualityViewer::QualityViewer(const char* _title, int _width, int _height)
     add_draw_mode("MeshDOG curvature");
     add_draw_mode("MeshDOG curvature DOG");
     add_draw_mode("MeshDOG feature points");
-    
-    /// add vertex property
-    mesh_.add_property(vmeshdog_f_);
-    mesh_.add_property(vmeshdog_dog_);
-    mesh_.add_property(veavg_);
-    mesh_.add_property(vgaussianconv_);
+    geodesic_mode_ = add_draw_mode("Geodesic Distance");
+
     
     /// default num of iters for gaussian conv
     _iters = 10;
+    field_budget_ = 0;
+    colored_field_ = -1;
+    colored_revision_ = face_colors_revision_ = 0;
+    dog_ranking_revision_ = 0;
+    dog_first_ = 0;
+    dog_fraction_ = 0.95;
+    dog_threshold_ = 0.0f;
+    use_dog_threshold_ = false;
+    dog_budget_ = 0;
+    dog_grid_ = 0;
+    dog_radius_ = 0.0f;
+    geodesics_time_ = 1.0f;
 
     init();
 }
@@ -146,19 +152,22 @@ bool QualityViewer::open_mesh(const char* _filename)
     // load mesh
     if (MeshViewer::open_mesh(_filename))
     {
-        // compute curvature stuff
-        calc_weights();
-        calc_mean_curvature();
-        calc_uniform_mean_curvature();
-        calc_gauss_curvature();
-        calc_triangle_quality();
-        face_color_coding();
+        // curvature stuff is computed when the detection or a draw mode
+        // first needs it, an up-to-date cache provides it right away
+        view_.pull(mesh_);
+        geodesics_.clear();
+        load_dog_inputs();
+        if ((!cache_loaded_ || !load_cached_fields()) && use_cache_)
+            save_cache(_filename);
         
         //==MeshDOG============================================================
         init_meshdog();
         detect_meshdog(_iters);
         save_meshdog();
 
+        release_intermediate_fields();
+        memory_report();
+
         glutPostRedisplay();
         return true;
     }
@@ -168,246 +177,131 @@ bool QualityViewer::open_mesh(const char* _filename)
 
 //-----------------------------------------------------------------------------
 
-
-
-void QualityViewer::calc_weights()
+void QualityViewer::cache_fields(MeshCache& _cache)
 {
-    Mesh::VertexIter        v_it, v_end(mesh_.vertices_end());
-    Mesh::EdgeIter          e_it, e_end(mesh_.edges_end());
-    Mesh::VertexFaceIter    vf_it;
-    Mesh::FaceVertexIter    fv_it;
-    Mesh::HalfedgeHandle    h0, h1, h2;
-    Mesh::VertexHandle      v0, v1;
-    Mesh::Point             p0, p1, p2, d0, d1;
-    Mesh::Scalar            w, area;
-
-
-
-    for (e_it=mesh_.edges_begin(); e_it!=e_end; ++e_it)
-    {
-        w  = 0.0;
-
-        h0 = mesh_.halfedge_handle(e_it.handle(), 0);
-        v0 = mesh_.to_vertex_handle(h0);
-        p0 = mesh_.point(v0);
-
-        h1 = mesh_.halfedge_handle(e_it.handle(), 1);
-        v1 = mesh_.to_vertex_handle(h1);
-        p1 = mesh_.point(v1);
-
-        h2 = mesh_.next_halfedge_handle(h0);
-        p2 = mesh_.point(mesh_.to_vertex_handle(h2));
-        d0 = (p0 - p2).normalize();
-        d1 = (p1 - p2).normalize();
-        w += 1.0 / tan(acos(std::min(0.99f, std::max(-0.99f, (d0|d1)))));
-
-        h2 = mesh_.next_halfedge_handle(h1);
-        p2 = mesh_.point(mesh_.to_vertex_handle(h2));
-        d0 = (p0 - p2).normalize();
-        d1 = (p1 - p2).normalize();
-        w += 1.0 / tan(acos(std::min(0.99f, std::max(-0.99f, (d0|d1)))));
-
-        w = std::max(0.0f, w);
-        mesh_.property(eweight_,e_it) = w;
-    }
-
-
-    for (v_it=mesh_.vertices_begin(); v_it!=v_end; ++v_it)
+    static const struct { const char* name; MeshView::Field_id id; } fields[] = {
+        { "vweight",         MeshView::VWEIGHT },
+        { "vcurvature",      MeshView::CURVATURE },
+        { "vunicurvature",   MeshView::UNICURVATURE },
+        { "vgausscurvature", MeshView::GAUSSCURVATURE },
+        { "eweight",         MeshView::EWEIGHT },
+        { "tshape",          MeshView::TSHAPE } };
+
+    // compute the fields that are not there yet, concurrently
+    MeshView::Field_id ids[sizeof(fields)/sizeof(fields[0])];
+    for (unsigned i = 0; i < sizeof(fields)/sizeof(fields[0]); ++i)
+        ids[i] = fields[i].id;
+    view_.require(ids, sizeof(ids)/sizeof(ids[0]));
+
+    for (unsigned i = 0; i < sizeof(fields)/sizeof(fields[0]); ++i)
     {
-        area = 0.0;
-
-        for (vf_it=mesh_.vf_iter(v_it); vf_it; ++vf_it)
-        {
-            fv_it = mesh_.fv_iter(vf_it);
- 
-            const Mesh::Point& P = mesh_.point(fv_it);  ++fv_it;
-            const Mesh::Point& Q = mesh_.point(fv_it);  ++fv_it;
-            const Mesh::Point& R = mesh_.point(fv_it);
-
-            area += ((Q-P)%(R-P)).norm() * 0.5f * 0.3333f;
-        }
-
-        mesh_.property(vweight_,v_it) = 1.0 / (2.0 * area);
+        const MeshView::Field& field = view_.require(fields[i].id);
+        _cache.add_section(fields[i].name, &field[0], field.size()*sizeof(float));
     }
 }
 
 //-----------------------------------------------------------------------------
 
-void QualityViewer::calc_mean_curvature()
+// copy a cached field of _n values into the view
+static bool read_field(const MeshCache& _cache, const char* _name, size_t _n,
+                       MeshView& _view, MeshView::Field_id _id)
 {
-    Mesh::VertexIter        v_it, v_end(mesh_.vertices_end());
-    Mesh::HalfedgeHandle    h;
-    Mesh::EdgeHandle        e;
-    Mesh::VertexVertexIter  vv_it;
-    Mesh::Point             laplace(0.0, 0.0, 0.0);
-
-    // ------------- IMPLEMENT HERE ---------
-    // TASK 4.3.a Approximate mean curvature using the length of the Laplace-Beltrami approximation
-    // Save your approximation in vcurvature_ vertex property of the mesh.
-    // Use the weights from calc_weights(): eweight_ and vweight_
-    // ------------- IMPLEMENT HERE ---------
-
-    // the outgoing vertex half edge iterator
-    Mesh::VertexOHalfedgeIter voh_it;
-    Mesh::VertexHandle vi;
-    Mesh::Point vvi;
-
-    for (v_it = mesh_.vertices_begin(); v_it != v_end; ++v_it)
-    {
-        laplace[0] = laplace[1] = laplace[2] = 0.0;
-        for(voh_it = mesh_.voh_iter(v_it); voh_it; ++voh_it)
-        {
-            // get vi handle and vi - v
-            vi = mesh_.to_vertex_handle(voh_it);
-            vvi = mesh_.point(vi) - mesh_.point(v_it);
-
-            // get edge handle where vi is on
-            e = mesh_.edge_handle(voh_it.handle());
-
-            // sum(wi * (vi - v))
-            laplace += mesh_.property(eweight_, e) * vvi;
-        }
-
-        // use half of the norm of LB(v) as mean curvature
-        mesh_.property(vcurvature_, v_it) = (mesh_.property(vweight_, v_it) * laplace).norm() / 2;
-    }
+    const float* field = _cache.section<float>(_name, _n);
+    if (!field) return false;
 
+    _view.set_field(_id, field, _n);
+    return true;
 }
 
-void QualityViewer::calc_uniform_mean_curvature()
+bool QualityViewer::load_cached_fields()
 {
-    Mesh::VertexIter        v_it, v_end(mesh_.vertices_end());
-    Mesh::VertexVertexIter  vv_it;
-    Mesh::Point             laplace(0.0, 0.0, 0.0);
-
-    // ------------- IMPLEMENT HERE ---------
-    // TASK 4.1.a Approximate mean curvature using the length of the uniform Laplacian approximation
-    // Save your approximation in vunicurvature_ vertex property of the mesh.
-    // ------------- IMPLEMENT HERE ---------
-    Mesh::Scalar counter;
-
-    for (v_it = mesh_.vertices_begin(); v_it != v_end; ++v_it)
+    const size_t nv(mesh_.n_vertices()), nf(mesh_.n_faces());
+    std::vector<Mesh::EdgeHandle> edges;
+    cached_edges(edges);
+
+    const float* eweight = cache_.section<float>("eweight", edges.size());
+    if (!eweight || edges.size() != mesh_.n_edges())
+        return false;
+
+    if (!read_field(cache_, "vweight",         nv, view_, MeshView::VWEIGHT)        ||
+        !read_field(cache_, "vcurvature",      nv, view_, MeshView::CURVATURE)      ||
+        !read_field(cache_, "vunicurvature",   nv, view_, MeshView::UNICURVATURE)   ||
+        !read_field(cache_, "vgausscurvature", nv, view_, MeshView::GAUSSCURVATURE) ||
+        !read_field(cache_, "tshape",          nf, view_, MeshView::TSHAPE))
+        return false;
+
+    // the cache stores the edges by their vertices
+    std::vector<float> weights(edges.size());
+    for (unsigned i = 0; i < edges.size(); ++i)
     {
-        laplace[0] = laplace[1] = laplace[2] = counter = 0.0;
-        
-        for(vv_it = mesh_.vv_iter( v_it ); vv_it; ++vv_it)
-        {
-            laplace += mesh_.point( vv_it );
-            counter++;
-        }
-
-        // get Lu(v) and vunicurvature_
-        laplace = (laplace / counter) - mesh_.point( v_it );
-        mesh_.property(vunicurvature_, v_it) = laplace.norm() / 2;
-
+        if (!edges[i].is_valid()) return false;
+        weights[edges[i].idx()] = eweight[i];
     }
+    view_.set_field(MeshView::EWEIGHT, &weights[0], weights.size());
 
-}
-
-void QualityViewer::calc_gauss_curvature()
-{
-    Mesh::VertexIter        v_it, v_end(mesh_.vertices_end());
-    Mesh::VertexVertexIter  vv_it, vv_it2;
-    Mesh::Point             d0, d1, d2;
-    Mesh::Scalar            angles, cos_angle;
-    Mesh::Scalar            lb(-1.0), ub(1.0);
-
-    // ------------- IMPLEMENT HERE ---------
-    // TASK 4.4 Approximate Gaussian curvature.
-    // Hint: When calculating angles out of cross products make sure the value 
-    // you pass to the acos function is between -1.0 and 1.0.
-    // Use the vweight_ property for the area weight.
-    // ------------- IMPLEMENT HERE ---------
-
-    Mesh::Scalar vert_weight;
-    for( v_it = mesh_.vertices_begin(); v_it != v_end; ++v_it)
-    {
-        angles = 0.0;
-        d2 = mesh_.point( v_it );
-        for(vv_it = mesh_.vv_iter(v_it); vv_it; ++vv_it)
-        {
-            vv_it2 = vv_it;
-            ++vv_it;
-
-            d0 = mesh_.point( vv_it2 ) - d2;
-            d1 = mesh_.point( vv_it ) - d2;
-
-            cos_angle = (d0[0] * d1[0] + d0[1] * d1[1] + d0[2] * d1[2]) / ( d0.norm() * d1.norm() );
-
-            if (cos_angle < -1.0)
-                cos_angle = -1.0;
-            else if (cos_angle > 1.0)
-                cos_angle = 1.0;
-
-            angles += acos(cos_angle);
-            --vv_it;
-        }
-
-        vert_weight = mesh_.property(vweight_, v_it);
-        mesh_.property(vgausscurvature_, v_it) = 2 * vert_weight * ( 2 * 3.1415926 - angles );
-    }
+    return true;
 }
 
 //-----------------------------------------------------------------------------
 
+void QualityViewer::release_intermediate_fields()
+{
+    // weights are read by the curvatures, the triangle shapes by
+    // face_color_coding() and e_avg by detect_meshdog(), the colors are
+    // kept; require() recomputes them if they are needed again. e_avg
+    // stays while the feature points are thinned out by it
+    view_.release(MeshView::VWEIGHT);
+    view_.release(MeshView::EWEIGHT);
+    view_.release(MeshView::TSHAPE);
+    if (dog_radius_ <= 0.0f)
+        view_.release(MeshView::EAVG);
+
+    if (field_budget_)
+        view_.trim(field_budget_);
+}
 
-void QualityViewer::calc_triangle_quality()
+void QualityViewer::memory_report()
 {
-    Mesh::FaceIter              f_it, f_end(mesh_.faces_end());
-    Mesh::ConstFaceVertexIter   cfvIt;
-    OpenMesh::Vec3f             v0,v1,v2;
-    OpenMesh::Vec3f             v0v1,v0v2,v1v2;
-    Mesh::Scalar                denom, circum_radius_sq, min_length_sq;
-
-    // ------------- IMPLEMENT HERE ---------
-    // TASK 4.2 Compute triangle shape measure and save it in the tshape_ property
-    // For numerical stability you might want to set the property value to
-    // a predifined large value (e.g. FLT_MAX) if the denominator is smaller than FLT_MIN
-    // ------------- IMPLEMENT HERE ---------
-
-    float a,b,c;
-    for(f_it = mesh_.faces_sbegin(); f_it != f_end; ++f_it)
-    {
-        // initialize fv_iter
-        cfvIt = mesh_.fv_iter( f_it );
-
-        // get the vertex of triangle
-        v0 = mesh_.point( cfvIt ); ++cfvIt;
-        v1 = mesh_.point( cfvIt ); ++cfvIt;
-        v2 = mesh_.point( cfvIt );
-
-        // get the edge
-        v0v1 = v1 - v0; a = v0v1.norm();
-        v0v2 = v2 - v0; b = v0v2.norm();
-        v1v2 = v1 - v2; c = v1v2.norm();
-
-        // get the min_length_sq
-        min_length_sq = FLT_MAX;
-        min_length_sq = std::min(a, min_length_sq);
-        min_length_sq = std::min(b, min_length_sq);
-        min_length_sq = std::min(c, min_length_sq);
-
-        denom = std::sqrt(std::pow(v0v1[1]*v0v2[2] - v0v1[2]*v0v2[1], 2) +
-            std::pow(v0v1[2]*v0v2[0] - v0v1[0]*v0v2[2], 2) + 
-            std::pow(v0v1[0]*v0v2[1] - v0v1[1]*v0v2[0], 2));
-
-        if ( denom < FLT_MIN )
-            mesh_.property(tshape_, f_it) = FLT_MAX;
-        else
-        {
-            circum_radius_sq = ( a * b * c ) / ( 2 * denom );
-            mesh_.property(tshape_, f_it) = circum_radius_sq / min_length_sq;
-        }
-    }
+    const double kb = 1.0 / 1024;
+    const size_t nv(mesh_.n_vertices()), ne(mesh_.n_edges()), nf(mesh_.n_faces());
+
+    // OpenMesh array kernel: a halfedge handle per vertex and face, two
+    // halfedges of four handles per edge, plus the standard attributes
+    size_t connectivity = nv*4 + ne*32 + nf*4;
+    size_t attributes   = nv*(sizeof(Mesh::Point) + sizeof(Mesh::Normal) + sizeof(Mesh::Color) + 1)
+                        + nf*sizeof(Mesh::Normal);
+    size_t buffers      = indices_.capacity()*sizeof(unsigned int) + face_colors_.capacity()*sizeof(float)
+                        + scratch_.capacity();
+
+    std::cout << "Memory of " << nv << " vertices:\n"
+              << "  mesh connectivity      " << connectivity * kb << " KB\n"
+              << "  mesh attributes        " << attributes * kb << " KB\n"
+              << "  draw buffers, scratch  " << buffers * kb << " KB\n";
+    view_.report(std::cout);
+    if (!geodesics_.empty())
+        std::cout << "  heat method factors    " << geodesics_.bytes() * kb << " KB\n";
+    std::cout << "  total                  " << (connectivity + attributes + buffers + view_.bytes() + geodesics_.bytes()) * kb << " KB\n";
+
+    // the view fields and kernel arrays among them, by page backing
+    std::cout << "  ";
+    HugePageArena::report(std::cout);
 }
 
 //-----------------------------------------------------------------------------
 
+
+
 void QualityViewer::face_color_coding()
 {
     Mesh::ConstFaceIter        f_it, f_end(mesh_.faces_end());
     Mesh::Scalar      sh, min_shape(FLT_MAX), max_shape(-FLT_MAX);
     Mesh::Color       col;
+    const MeshView::Field& tshape(view_.require(MeshView::TSHAPE));
+
+    // still up to date
+    if (!face_colors_.empty() && face_colors_revision_ == view_.revision(MeshView::TSHAPE))
+        return;
+    face_colors_revision_ = view_.revision(MeshView::TSHAPE);
 
     face_colors_.clear();
     face_colors_.reserve(mesh_.n_faces()*3);
@@ -418,7 +312,7 @@ void QualityViewer::face_color_coding()
     // map curvatures to colors
     for (f_it = mesh_.faces_sbegin(); f_it!=f_end; ++f_it)
     {
-        sh = mesh_.property(tshape_,f_it);
+        sh = tshape[f_it.handle().idx()];
         col = value_to_color(sh, min_shape, max_shape);
 
         face_colors_.push_back((float)col[0]/255);
@@ -429,29 +323,38 @@ void QualityViewer::face_color_coding()
 
 //-----------------------------------------------------------------------------
 
-void QualityViewer::color_coding(Vertex_property prop)
+void QualityViewer::color_coding(MeshView::Field_id _id)
 {
     Mesh::VertexIter  v_it, v_end(mesh_.vertices_end());
     Mesh::Scalar      curv, min(FLT_MAX), max(-FLT_MAX);
     Mesh::Color       col;
+    const MeshView::Field& field(view_.require(_id));
     
-    // put all values into one array
-    std::vector<Mesh::Scalar> values;
-    values.reserve(mesh_.n_vertices());
+    // the colors still show this field
+    if (colored_field_ == _id && colored_revision_ == view_.revision(_id))
+        return;
+    colored_field_    = _id;
+    colored_revision_ = view_.revision(_id);
+
+    // put all values into one array, drawn from the scratch arena since
+    // this runs whenever the field changes
+    ScratchArena::Frame frame(scratch_);
+    Mesh::Scalar* values = scratch_.allocate<Mesh::Scalar>(mesh_.n_vertices());
+    unsigned int  n_values(0);
     for (v_it=mesh_.vertices_begin(); v_it!=v_end; ++v_it)
-        values.push_back(mesh_.property(prop, v_it));
+        values[n_values++] = field[v_it.handle().idx()];
 
     //discard upper and lower 5%
-    unsigned int n = values.size()-1;
+    unsigned int n = n_values-1;
     unsigned int i = n / 20;
-    std::sort(values.begin(), values.end());
+    std::sort(values, values + n_values);
     min = values[i];
     max = values[n-1-i];
 
     // map curvatures to colors
     for (v_it=mesh_.vertices_begin(); v_it!=v_end; ++v_it)
     {
-        curv = mesh_.property(prop, v_it);
+        curv = field[v_it.handle().idx()];
         mesh_.set_color(v_it, value_to_color(curv, min, max));
     }
 }
@@ -512,16 +415,21 @@ void QualityViewer::draw(const std::string& _draw_mode)
         return;
     }
 
-    if (_draw_mode == "Mean Curvature") color_coding(vcurvature_);
-    if (_draw_mode == "Gaussian Curvature") color_coding(vgausscurvature_);
-    if (_draw_mode == "Uniform Mean Curvature") color_coding(vunicurvature_);
+    if (_draw_mode == "Mean Curvature") color_coding(MeshView::CURVATURE);
+    if (_draw_mode == "Gaussian Curvature") color_coding(MeshView::GAUSSCURVATURE);
+    if (_draw_mode == "Uniform Mean Curvature") color_coding(MeshView::UNICURVATURE);
     
     //== MeshDOG ============================================================
-    if (_draw_mode == "MeshDOG curvature") color_coding(vmeshdog_f_);
-    if (_draw_mode == "MeshDOG curvature DOG") color_coding(vmeshdog_dog_);
+    if (_draw_mode == "MeshDOG curvature") color_coding(MeshView::DOG_F);
+    if (_draw_mode == "MeshDOG curvature DOG") color_coding(MeshView::DOG_DOG);
     //-----------------------------------------------------------------------
+    if (_draw_mode == "Geodesic Distance")
+    {
+        if (!view_.is_valid(MeshView::GEODESIC)) geodesic_distances(geodesics_time_);
+        color_coding(MeshView::GEODESIC);
+    }
     
-    if (_draw_mode == "Mean Curvature" || _draw_mode == "Gaussian Curvature" || _draw_mode == "Uniform Mean Curvature" || _draw_mode == "MeshDOG curvature" || _draw_mode == "MeshDOG curvature DOG")
+    if (_draw_mode == "Mean Curvature" || _draw_mode == "Gaussian Curvature" || _draw_mode == "Uniform Mean Curvature" || _draw_mode == "MeshDOG curvature" || _draw_mode == "MeshDOG curvature DOG" || _draw_mode == "Geodesic Distance")
     {
 
         glDisable(GL_LIGHTING);
@@ -544,6 +452,7 @@ void QualityViewer::draw(const std::string& _draw_mode)
 
     if (_draw_mode == "Triangle Shape")
     {
+        face_color_coding();
 
         glDisable(GL_LIGHTING);
         glShadeModel(GL_FLAT);
@@ -645,12 +554,11 @@ void QualityViewer::draw(const std::string& _draw_mode)
         glColor3f(0, 1.0, 0);
         glPointSize(5.0);
         
-        glEnableClientState(GL_VERTEX_ARRAY);
-        GL::glVertexPointer(mesh_.points());
-        
-        glDrawElements(GL_POINTS, static_cast<GLsizei>(_dog_feature_points.size()), GL_UNSIGNED_INT, &_dog_feature_points[0]);
-        
-        glDisableClientState(GL_VERTEX_ARRAY);
+        // _dog_feature_points hold file indices, so draw through the handles
+        glBegin(GL_POINTS);
+        for (unsigned i=0; i<_dog_feature_handles.size(); ++i)
+            GL::glVertex(mesh_.point(_dog_feature_handles[i]));
+        glEnd();
     }
 
     else MeshViewer::draw(_draw_mode);
@@ -661,147 +569,319 @@ void QualityViewer::draw(const std::string& _draw_mode)
 // == MeshDOG ==================================================================
 void QualityViewer::init_meshdog()
 {
-    // ------------- IMPLEMENT HERE ---------
-    // initialize the MeshDOG
-    // a). initialize the vmesh_ value to mean curvature
-    // ------------- IMPLEMENT HERE ---------
-    
-    // initialize the value to some type of curvature
-    Mesh::VertexIter v_it, v_end(mesh_.vertices_end());
-    Mesh::VertexVertexIter vv_it;
-    Mesh::Scalar eavg;
-    Mesh::Point v0, v1;
-    int valence = 0;
-    
-    for (v_it = mesh_.vertices_begin(); v_it != v_end; ++v_it)
+    // initialize the value to some type of curvature; the curvatures and
+    // the average edge length e_avg of each vertex are computed side by
+    // side first; a scale space of the current positions is kept, so that
+    // detect_meshdog() continues from the level it reached
+    if (view_.is_valid(MeshView::DOG_F) && view_.is_valid(MeshView::DOG_DOG))
+        return;
+
+    // only the functions convolved are computed, a missing input is 0
+    MeshView::Field_id needed[MeshView::max_dog_channels + 1] = { MeshView::EAVG };
+    for (size_t c = 0; c < view_.n_dog_channels(); ++c)
     {
-        // initialize the vmeshdog_ value to curvature
-        mesh_.property(vmeshdog_f_, v_it) = mesh_.property(vunicurvature_, v_it);
-        valence = 0; eavg = 0;
-        v0 = mesh_.point( v_it );
-        
-        // calculate e_avg for each vertex
-        for (vv_it = mesh_.vv_iter( v_it ); vv_it; ++vv_it)
-        {
-            v1 = mesh_.point( vv_it );
-            valence++;
-            eavg += (v0 - v1).norm();
-        }
-        
-        // delete single points
-        // techniquely not actually delete it, just set the f(v_i) to 0
-        if (valence == 0)
-            //mesh_.property(vmeshdog_f_, v_it) = 0;
-            std::cout<<mesh_.property(vcurvature_, v_it)<<std::endl;
-            //mesh_.delete_vertex(v_it);
-        else
-            mesh_.property(veavg_, v_it) = eavg / valence;
+        needed[1+c] = view_.dog_channel_id(c);
+        if (!dog_function_available(needed[1+c]))
+            std::cerr << "MeshDOG: no " << MeshView::field_name(needed[1+c]) << " loaded\n";
     }
-    
-    //mesh_.garbage_collection();
+    view_.require(needed, 1 + view_.n_dog_channels());
+    view_.init_meshdog();
+
+    // single points are not convolved, report them
+    unsigned int singles(0);
+    for (unsigned int v = 0; v < view_.n_vertices(); ++v)
+        if (view_.valence(v) == 0)
+            ++singles;
+    if (singles)
+        std::cout<<singles<<" single points"<<std::endl;
 }
 
 
 //-----------------------------------------------------------------------------
 void QualityViewer::detect_meshdog(int _iters)
 {
-    // ------------- IMPLEMENT HERE ---------
     // detect MeshDOG feature
     // b). gaussian convolution
     // c). thresholding, top 5% will be sorted
     // d). corner detection
-    // ------------- IMPLEMENT HERE ---------
-    Mesh::VertexIter            v_it, v_end(mesh_.vertices_end());
-    Mesh::VertexVertexIter      vv_it;
-    Mesh::Scalar                f0, f1(0);
-    Mesh::Point                 vi, vj;
-    float                       theta, k, K(0);
+
+    // perform gaussian convolution on the kernel view up to level _iters,
+    // continuing from the level of an earlier run, single points keep
+    // their value; only the functions convolved and e_avg are computed,
+    // side by side
+    const MeshView::Field_id    needed[] = { MeshView::DOG_DOG };
+    view_.set_dog_iterations(_iters);
+    view_.require(needed, 1);
+    const MeshView::Field&      dog(view_.require(MeshView::DOG_DOG));
     
-    // perform gaussian convolution
-    for (int i = 0; i < _iters; ++ i)
+    // thresholding; the vertices are ranked by their DoG value once per
+    // DoG field, a new threshold then only moves the cut in the ranking
+    if (dog_ranking_revision_ != view_.revision(MeshView::DOG_DOG))
     {
-        for (v_it = mesh_.vertices_begin(); v_it != v_end; ++ v_it)
-        {
-            // check if the vertex is a single point
-            if (!isnan(mesh_.property(vcurvature_, v_it)))
-            {
-                theta = mesh_.property(veavg_, v_it);
-                f0 = mesh_.property(vmeshdog_f_, v_it);
-                f1 = 0; K = 0;
-                vi = mesh_.point(v_it);
-                theta = pow(2, 1.0/3.0) * mesh_.property(veavg_, v_it);
-                
-                for (vv_it = mesh_.vv_iter(v_it); vv_it; ++vv_it)
-                {
-                    vj = mesh_.point(vv_it);
-                    k = gaussian_conv((vi - vj).norm(), theta); K += k;
-                    f1 += mesh_.property(vmeshdog_f_, vv_it) * k;
-                    //std::cout<<gaussian_conv((vi - vj).norm(), theta)<<std::endl;
-                }
-                f1 = f1 / K;
-                
-                mesh_.property(vmeshdog_dog_, v_it) = f1 - f0;
-                mesh_.property(vmeshdog_f_, v_it) = f1;
-            }
-        }
+        // a function can be NaN on degenerate triangles, it ranks as 0
+        // as in MeshKernel::select_features()
+        dog_sorted_.resize(dog.size());
+        for (unsigned int v = 0; v < dog.size(); ++v)
+            dog_sorted_[v] = isnan(dog[v]) ? 0.0f : dog[v];
+        std::sort(dog_sorted_.begin(), dog_sorted_.end());
+
+        // single points are never features
+        dog_ranking_.clear();
+        dog_ranking_.reserve(dog.size());
+        for (unsigned int v = 0; v < dog.size(); ++v)
+            if (view_.valence(v) > 0 && !isnan(dog[v]))
+                dog_ranking_.push_back(std::make_pair(dog[v], v));
+        std::sort(dog_ranking_.begin(), dog_ranking_.end());
+        dog_ranking_revision_ = view_.revision(MeshView::DOG_DOG);
+
+        // clear() keeps the capacity of earlier runs
+        dog_first_ = dog_ranking_.size();
+        _dog_feature_points.clear();
+        _dog_feature_handles.clear();
     }
+    select_meshdog();
     
     // debug
-//    for (v_it = mesh_.vertices_begin(); v_it != v_end; ++ v_it)
-//    {
-//        std::cout<< mesh_.property(vmeshdog_dog_, v_it) << std::endl;
-//    }
+    std::cout<<"Detected "<<_dog_feature_points.size()<<" feature points at level "<<view_.dog_level()<<std::endl;
     
-    // thresholding
-    std::vector<Mesh::Scalar>   vec_dog;
-    Mesh::Scalar                threshold;
-    std::vector<Mesh::VIter>    vec_viter;
-    //std::vector<int>            dog_feature_points;
-    int thresh_index = int(mesh_.n_vertices() * 0.95);
+    // corner detection
+    Mesh::Scalar dxx, dyy;
+    // conrner detection is not necessary for this project
+    // TODO
     
-    for (v_it = mesh_.vertices_begin(); v_it != v_end; ++v_it)
+}
+
+//-----------------------------------------------------------------------------
+void QualityViewer::select_meshdog()
+{
+    if (dog_sorted_.empty()) return;
+
+    if (dog_budget_)
     {
-        vec_dog.push_back(mesh_.property(vmeshdog_dog_, v_it));
+        // the ranked vertices are the candidates, the selection is not a
+        // cut in the ranking, so a threshold starts over from none
+        const MeshView::Field&     dog(view_.require(MeshView::DOG_DOG));
+        ScratchArena::Frame        frame(scratch_);
+        unsigned int*              candidates(scratch_.allocate<unsigned int>(dog_ranking_.size()));
+        std::vector<unsigned int>  features;
+        const float*               p(&mesh_.points()[0][0]);
+
+        for (size_t i = 0; i < dog_ranking_.size(); ++i)
+            candidates[i] = dog_ranking_[i].second;
+        FeatureGrid::select(p, p+1, p+2, sizeof(Mesh::Point)/sizeof(float), &dog[0],
+                            candidates, dog_ranking_.size(),
+                            dog_budget_, dog_grid_, features);
+
+        _dog_feature_points.clear();
+        _dog_feature_handles.clear();
+        for (size_t i = 0; i < features.size(); ++i)
+        {
+            Mesh::VertexHandle vh(features[i]);
+            _dog_feature_points.push_back(original_index(vh));
+            _dog_feature_handles.push_back(vh);
+        }
+        dog_first_ = dog_ranking_.size() + 1;
+        suppress_meshdog();
+        return;
     }
-    
-    std::sort(vec_dog.begin(), vec_dog.end());
-    threshold = vec_dog[thresh_index];
-    
+
+    if (dog_first_ > dog_ranking_.size())
+    {
+        _dog_feature_points.clear();
+        _dog_feature_handles.clear();
+        dog_first_ = dog_ranking_.size();
+    }
+
+    // the fraction of all vertices below the threshold, as the other
+    // front ends count it, or the absolute threshold
+    Mesh::Scalar threshold(dog_threshold_);
+    if (!use_dog_threshold_)
+    {
+        const size_t thresh_index = size_t(dog_sorted_.size() * dog_fraction_);
+        threshold = thresh_index < dog_sorted_.size()
+            ? dog_sorted_[thresh_index] : std::numeric_limits<Mesh::Scalar>::infinity();
+    }
+
+    // the features are the ranked vertices from the first one at the
+    // threshold on, kept in descending order so that the vertices that
+    // cross the threshold are pushed or popped at the back
+    const size_t first = std::lower_bound(dog_ranking_.begin(), dog_ranking_.end(),
+        std::make_pair(threshold, 0u)) - dog_ranking_.begin();
+
+    for (; dog_first_ > first; --dog_first_)
+    {
+        Mesh::VertexHandle vh(dog_ranking_[dog_first_-1].second);
+        _dog_feature_points.push_back(original_index(vh));
+        _dog_feature_handles.push_back(vh);
+    }
+    for (; dog_first_ < first; ++dog_first_)
+    {
+        _dog_feature_points.pop_back();
+        _dog_feature_handles.pop_back();
+    }
+    suppress_meshdog();
+}
+
+//-----------------------------------------------------------------------------
+void QualityViewer::suppress_meshdog()
+{
+    if (dog_radius_ <= 0.0f || _dog_feature_handles.size() < 2) return;
+
+    // the kept points are no cut in the ranking any more, a new
+    // threshold starts over from none
+    const MeshView::Field_id    needed[] = { MeshView::DOG_DOG, MeshView::EAVG };
+    view_.require(needed, 2);
+    const MeshView::Field&      dog(view_.field(MeshView::DOG_DOG));
+    const MeshView::Field&      eavg(view_.field(MeshView::EAVG));
+    const float*                p(&mesh_.points()[0][0]);
+    std::vector<unsigned int>   features(_dog_feature_handles.size());
+
+    for (size_t i = 0; i < features.size(); ++i)
+        features[i] = _dog_feature_handles[i].idx();
+    FeatureGrid::suppress(p, p+1, p+2, sizeof(Mesh::Point)/sizeof(float),
+                          &dog[0], &eavg[0], dog_radius_, features);
+
     _dog_feature_points.clear();
     _dog_feature_handles.clear();
-    
-    for( v_it = mesh_.vertices_begin(); v_it != v_end; ++v_it)
+    for (size_t i = 0; i < features.size(); ++i)
+    {
+        Mesh::VertexHandle vh(features[i]);
+        _dog_feature_points.push_back(original_index(vh));
+        _dog_feature_handles.push_back(vh);
+    }
+    dog_first_ = dog_ranking_.size() + 1;
+}
+
+//-----------------------------------------------------------------------------
+void QualityViewer::load_dog_inputs()
+{
+    const size_t n(view_.n_vertices());
+
+    // luminance of the colors read with the mesh
+    if (colors_loaded_)
     {
-        // if DOG exists and above threshold
-        if (!isnan(mesh_.property(vcurvature_, v_it)) && mesh_.property(vmeshdog_dog_, v_it) >= threshold)
+        ScratchArena::Frame frame(scratch_);
+        float* luminance = scratch_.allocate<float>(n);
+        for (size_t v = 0; v < n; ++v)
         {
-            _dog_feature_points.push_back(v_it.handle().idx());
-            _dog_feature_handles.push_back(v_it.handle());
+            const Mesh::Color& c = mesh_.color(Mesh::VertexHandle(v));
+            luminance[v] = (0.2126f*c[0] + 0.7152f*c[1] + 0.0722f*c[2]) / 255;
         }
+        view_.set_field(MeshView::LUMINANCE, luminance, n);
     }
-    
-    // debug
-    std::cout<<"Detected "<<_dog_feature_points.size()<<" feature points"<<std::endl;
-    
-    // corner detection
-    Mesh::Scalar dxx, dyy;
-    // conrner detection is not necessary for this project
-    // TODO
-    
+
+    // the file lists the vertices in their original order
+    if (!dog_function_file_.empty())
+    {
+        std::ifstream       in(dog_function_file_.c_str());
+        std::vector<float>  values, function(n);
+        float               value;
+
+        while (in >> value)
+            values.push_back(value);
+        if (values.size() != n)
+        {
+            std::cerr << dog_function_file_ << ": " << values.size() << " values for "
+                      << n << " vertices\n";
+            return;
+        }
+        for (size_t v = 0; v < n; ++v)
+            function[v] = values[original_index(Mesh::VertexHandle(v))];
+        view_.set_field(MeshView::USER_FUNCTION, &function[0], n);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool QualityViewer::dog_function_available(MeshView::Field_id _id) const
+{
+    if (_id == MeshView::LUMINANCE || _id == MeshView::USER_FUNCTION)
+        return view_.has_field(_id);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void QualityViewer::show_dog_channel(size_t _ch)
+{
+    // the ranking follows the new DoG field, the threshold stays
+    view_.set_dog_channel(_ch);
+    if (view_.is_valid(MeshView::DOG_DOG))
+        detect_meshdog(_iters);
+}
+
+//-----------------------------------------------------------------------------
+void QualityViewer::geodesic_distances(float _time_factor)
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start(Clock::now());
+
+    if (geodesics_.empty() || geodesics_time_ != _time_factor)
+    {
+        geodesics_time_ = _time_factor;
+        if (!geodesics_.build(view_, _time_factor))
+        {
+            std::cerr << "Heat method: factorization failed\n";
+            return;
+        }
+        std::cout << "Heat method factors: " << geodesics_.n_entries() << " entries, "
+                  << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms\n";
+        start = Clock::now();
+    }
+
+    // from the feature points, or from the first vertex without any
+    std::vector<unsigned int>  sources(1, 0);
+    if (!_dog_feature_handles.empty())
+    {
+        sources.resize(_dog_feature_handles.size());
+        for (size_t i = 0; i < sources.size(); ++i)
+            sources[i] = _dog_feature_handles[i].idx();
+    }
+
+    std::vector<float>  dist(view_.n_vertices());
+    geodesics_.distances(&sources[0], sources.size(), &dist[0]);
+    view_.set_field(MeshView::GEODESIC, &dist[0], dist.size());
+    std::cout << "Geodesic distances from " << sources.size() << " sources: "
+              << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms\n";
+}
+
+//-----------------------------------------------------------------------------
+void QualityViewer::set_dog_fraction(double _fraction)
+{
+    dog_budget_ = 0;
+    dog_fraction_ = std::max(0.0, std::min(1.0, _fraction));
+    use_dog_threshold_ = false;
+    select_meshdog();
+}
+
+//-----------------------------------------------------------------------------
+void QualityViewer::set_dog_threshold(float _threshold)
+{
+    dog_budget_ = 0;
+    dog_threshold_ = _threshold;
+    use_dog_threshold_ = true;
+    select_meshdog();
+}
+
+//-----------------------------------------------------------------------------
+void QualityViewer::set_dog_budget(size_t _budget, unsigned int _resolution)
+{
+    dog_budget_ = _budget;
+    dog_grid_ = _resolution;
+    select_meshdog();
+}
+
+//-----------------------------------------------------------------------------
+void QualityViewer::set_dog_radius(float _radius)
+{
+    // from the unthinned selection, a smaller radius brings points back
+    dog_radius_ = std::max(0.0f, _radius);
+    select_meshdog();
 }
 
 //-----------------------------------------------------------------------------
 float QualityViewer::gaussian_conv(float _edge_length, float _theta)
 {
-    // ------------- IMPLEMENT HERE ---------
-    // helper function for gaussian conv
-    // return k(||vivj||) of the paper
-    // ------------- IMPLEMENT HERE ---------
-
-    float k;
-    k = exp(-pow(_edge_length, 2) / (2 * pow(_theta, 2)))
-    / (_theta * sqrt(2 * M_PI));
-    return k;
+    // k(||vivj||) of the paper
+    return MeshView::gaussian(_edge_length, _theta);
 }
 
 //-----------------------------------------------------------------------------
@@ -811,6 +891,8 @@ void QualityViewer::save_meshdog()
     Mesh::VertexHandle vh;
     std::vector<Mesh::VertexHandle>::iterator iter;
     
+    // only the points of this run
+    new_mesh.clear();
     for(iter = _dog_feature_handles.begin(); iter != _dog_feature_handles.end(); ++iter)
     {
         vh = *iter;
@@ -821,6 +903,13 @@ void QualityViewer::save_meshdog()
     // save mesh to file
     if ( !OpenMesh::IO::write_mesh(new_mesh, "dog_points.ply" ))
         std::cout<<"Failed to save the mesh!"<<std::endl;
+    
+    // vertex indices of the feature points in the input file
+    std::ofstream ofs("dog_points.txt");
+    for (unsigned i = 0; i < _dog_feature_points.size(); ++i)
+        ofs << _dog_feature_points[i] << "\n";
+    if (!ofs)
+        std::cout<<"Failed to save the feature indices!"<<std::endl;
 }
 
 //=============================================================================
@@ -42,6 +42,9 @@
 //== INCLUDES =================================================================
 
 #include "MeshViewer.hh"
+#include "ScratchArena.hh"
+#include "MeshView.hh"
+#include "HeatGeodesics.hh"
 
 //== CLASS DEFINITION =========================================================
 
@@ -58,6 +61,59 @@ public:
     /// open mesh
     virtual bool open_mesh(const char* _filename);
     
+    /// cap on the memory of the view fields kept between interactions,
+    /// 0 for no cap
+    void set_field_budget(size_t _bytes) { field_budget_ = _bytes; }
+
+    /// fraction of the vertices below the DoG threshold, the feature
+    /// points follow right away without another convolution
+    void set_dog_fraction(double _fraction);
+    double dog_fraction() const { return dog_fraction_; }
+
+    /// absolute DoG threshold to use instead of the fraction
+    void set_dog_threshold(float _threshold);
+
+    /// at most _budget feature points spread over a uniform grid with
+    /// _resolution cells along the longest side (0: from the budget),
+    /// instead of a threshold; 0 returns to the threshold
+    void set_dog_budget(size_t _budget, unsigned int _resolution = 0);
+    size_t dog_budget() const { return dog_budget_; }
+
+    /// drop feature points within _radius average edge lengths of a
+    /// stronger one, 0 for none
+    void set_dog_radius(float _radius);
+    float dog_radius() const { return dog_radius_; }
+
+    /// convolve over the _k-rings or within a geodesic _radius in fewer
+    /// passes, the table is in memory_report()
+    void set_dog_rings(unsigned int _k)   { view_.set_dog_rings(_k); }
+    void set_dog_geodesic(float _radius) { view_.set_dog_geodesic(_radius); }
+
+    /// update the DoG after each pass, in parallel and independent of
+    /// the vertex order, instead of in place
+    void set_dog_jacobi(bool _jacobi) { view_.set_dog_jacobi(_jacobi); }
+
+    /// convolve the _n per-vertex fields _ids in one pass, the feature
+    /// points come from the one shown, the first at first
+    void set_dog_channels(const MeshView::Field_id* _ids, size_t _n) { view_.set_dog_channels(_ids, _n); }
+
+    /// feature points of channel _ch, from the last detection without
+    /// another convolution
+    void show_dog_channel(size_t _ch);
+
+    /// values of the USER_FUNCTION channel, one per vertex in the order
+    /// of the mesh file, read by open_mesh()
+    void set_dog_function_file(const char* _filename) { dog_function_file_ = _filename; }
+
+    /// the curvatures can always be convolved, the color luminance and
+    /// the user function once they are loaded
+    bool dog_function_available(MeshView::Field_id _id) const;
+
+    /// geodesic distances from the feature points by the heat method,
+    /// _time_factor scales its time step; the factors are built on the
+    /// first call and kept until the positions change
+    void geodesic_distances(float _time_factor = 1.0f);
+    
     ///== MeshDOG =============================================================
     int _iters;
 
@@ -70,29 +126,44 @@ protected:
     virtual void draw(const std::string& _draw_mode);
 
 
-    /// calculate vertex and edge weights
-    void calc_weights();
-
-    /// calculate mean curvature per vertex
-    void calc_mean_curvature();
-    void calc_uniform_mean_curvature();
-
-    void calc_gauss_curvature();
-
-    /// calculate triangle shape indices
-    void calc_triangle_quality();
+    /// set face colors from the triangle shape indices
     void face_color_coding();
 
     void find_min_max(Vertex_property prop, Mesh::Scalar& min, Mesh::Scalar& max);
     Mesh::Color value_to_color(float value, float min, float max);
 
-    /// set vertex color from vertex curvature
-    void color_coding(Vertex_property prop);
+    /// set vertex color from a per-vertex field of view_, the field is
+    /// computed if needed and the colors are kept while it is unchanged
+    void color_coding(MeshView::Field_id _id);
+
+    /// cache weights, curvatures and triangle shapes with the mesh
+    virtual void cache_fields(MeshCache& _cache);
+
+    /// restore the fields of cache_fields() from the loaded cache
+    bool load_cached_fields();
+
+    /// free the fields that are only inputs of curvature and detection,
+    /// then trim the view to the field budget
+    void release_intermediate_fields();
+
+    /// print the memory held by the mesh, the view and its fields
+    void memory_report();
+
+
+    /// structure-of-arrays copy of mesh_ the numeric kernels run on,
+    /// it owns all computed fields
+    MeshView      view_;
+
+    /// temporaries of color coding and detection, reused across runs
+    ScratchArena  scratch_;
 
+    /// bytes the view fields may keep, 0 for no cap
+    size_t        field_budget_;
 
-    OpenMesh::VPropHandleT<Mesh::Scalar>  vweight_, vunicurvature_, vcurvature_, vgausscurvature_;
-    OpenMesh::EPropHandleT<Mesh::Scalar>  eweight_;
-    OpenMesh::FPropHandleT<Mesh::Scalar>  tshape_;
+    /// field and its revision the vertex colors show, the revision of
+    /// the triangle shapes in face_colors_
+    int           colored_field_;
+    unsigned int  colored_revision_, face_colors_revision_;
     
     //== MeshDOG ===============================================================
     
@@ -102,18 +173,59 @@ protected:
     /// detect MeshDOG feature
     void detect_meshdog(int _iters);
     
+    /// update the feature points to the current threshold, only the
+    /// vertices that cross it are added or removed
+    void select_meshdog();
+    
+    /// thin out the feature points by dog_radius_
+    void suppress_meshdog();
+    
+    /// LUMINANCE from the vertex colors of the file and USER_FUNCTION
+    /// from dog_function_file_, if there are any
+    void load_dog_inputs();
+    
     /// gaussian convolution
     float gaussian_conv(float _edge_length, float _theta);
     
     /// save the feature points to a mesh
     void save_meshdog();
     
-    /// vertex handle for MeshDOG scalar value f
-    OpenMesh::VPropHandleT<Mesh::Scalar> vmeshdog_f_, vmeshdog_dog_, veavg_, vgaussianconv_;
-    
-    /// the detected feature points
+    /// the detected feature points (indices refer to the input file)
     std::vector<int> _dog_feature_points;
     std::vector<Mesh::VertexHandle> _dog_feature_handles;
+    
+    /// DoG values of all vertices in ascending order, and the (value,
+    /// vertex) pairs of the vertices that can be features, ranked the
+    /// same way; kept from the DoG field of revision dog_ranking_revision_
+    std::vector<float>                             dog_sorted_;
+    std::vector<std::pair<float, unsigned int> >   dog_ranking_;
+    unsigned int  dog_ranking_revision_;
+    
+    /// start of the feature points in dog_ranking_, past its end while
+    /// they come from the grid or are thinned out
+    size_t        dog_first_;
+    
+    /// threshold of the feature points, a fraction of the vertices below
+    /// it or an absolute DoG value
+    double        dog_fraction_;
+    float         dog_threshold_;
+    bool          use_dog_threshold_;
+    
+    /// feature budget and resolution of the grid selection, 0 for none
+    size_t        dog_budget_;
+    unsigned int  dog_grid_;
+    
+    /// suppression radius in units of e_avg, 0 for none
+    float         dog_radius_;
+    
+    /// file of the user function, empty for none
+    std::string   dog_function_file_;
+    
+    /// heat method factors of the current positions, empty after they
+    /// change, and the time factor they were built with
+    HeatGeodesics geodesics_;
+    float         geodesics_time_;
+    unsigned int  geodesic_mode_;   // its draw mode
     GLuint  textureID_;
     
     // new mesh for MeshDOG feature points
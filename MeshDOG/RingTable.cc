@@ -0,0 +1,313 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS RingTable - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "RingTable.hh"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <math.h>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+namespace {
+
+// bounded search from one vertex, the vertices it reached in a small
+// open addressing table that is emptied slot by slot for the next one,
+// so a search costs the size of its neighborhood and not of the mesh
+struct Search
+{
+  enum { none = ~0u };
+
+  Search() : keys(256, none), dist(256), bits(8) {}
+
+  /// distance slot of _v, _added tells whether _v is new to the search;
+  /// valid until the next visit()
+  float& visit(unsigned int _v, bool& _added)
+  {
+    if (2 * (used.size()+1) > keys.size())
+      grow();
+
+    const size_t  mask(keys.size()-1);
+    size_t        i((_v * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+    while (keys[i] != none && keys[i] != _v)
+      i = (i+1) & mask;
+
+    _added = keys[i] == none;
+    if (_added)
+    {
+      keys[i] = _v;
+      used.push_back(i);
+    }
+    return dist[i];
+  }
+
+  /// forget the vertices of the last search
+  void reset()
+  {
+    for (size_t i=0; i<used.size(); ++i)
+      keys[used[i]] = none;
+    used.clear();
+  }
+
+  /// twice the slots, for neighborhoods larger than any before
+  void grow()
+  {
+    std::vector<unsigned int>  old_keys;
+    std::vector<float>         old_dist;
+    std::vector<size_t>        old_used;
+    bool                       added;
+
+    old_keys.swap(keys);
+    old_dist.swap(dist);
+    old_used.swap(used);
+    keys.assign(2 * old_keys.size(), none);
+    dist.resize(2 * old_dist.size());
+    ++bits;
+    for (size_t i=0; i<old_used.size(); ++i)
+      visit(old_keys[old_used[i]], added) = old_dist[old_used[i]];
+  }
+
+  std::vector<unsigned int>  keys, ring, next;
+  std::vector<float>         dist;
+  std::vector<size_t>        used;   // slots taken by this search
+  int                        bits;   // log2 of the slots
+  std::priority_queue<std::pair<float, unsigned int>,
+                      std::vector<std::pair<float, unsigned int> >,
+                      std::greater<std::pair<float, unsigned int> > >  heap;
+};
+
+inline float
+edge_length(const float* _x, const float* _y, const float* _z, size_t _stride,
+         unsigned int _a, unsigned int _b)
+{
+  const size_t  a(_a*_stride), b(_b*_stride);
+  const float   dx(_x[a]-_x[b]), dy(_y[a]-_y[b]), dz(_z[a]-_z[b]);
+  return sqrtf(dx*dx + dy*dy + dz*dz);
+}
+
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+RingTable::
+RingTable()
+  : reach_(0.0f)
+{
+}
+
+
+void
+RingTable::
+clear()
+{
+  Indices().swap(offsets_);
+  Indices().swap(neighbors_);
+  Field().swap(distances_);
+  reach_ = 0.0f;
+}
+
+
+size_t
+RingTable::
+bytes() const
+{
+  return (offsets_.capacity() + neighbors_.capacity()) * sizeof(unsigned int)
+    + distances_.capacity() * sizeof(float);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+int
+RingTable::
+passes(int _steps) const
+{
+  if (_steps <= 0) return 0;
+  if (reach_ <= 1.0f) return _steps;
+  return std::max(1, (int)ceil(_steps / (reach_ * reach_)));
+}
+
+
+float
+RingTable::
+theta_scale(int _steps) const
+{
+  const int p(passes(_steps));
+  return p ? sqrtf(float(_steps) / p) : 1.0f;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+RingTable::
+build_rings(const unsigned int* _offsets, const unsigned int* _neighbors,
+            size_t _n_vertices, const float* _x, const float* _y,
+            const float* _z, size_t _stride, unsigned int _k)
+{
+  build(_offsets, _neighbors, _n_vertices, _x, _y, _z, _stride, 0, _k, false);
+}
+
+
+void
+RingTable::
+build_geodesic(const unsigned int* _offsets, const unsigned int* _neighbors,
+               size_t _n_vertices, const float* _x, const float* _y,
+               const float* _z, size_t _stride, const float* _eavg,
+               float _radius)
+{
+  build(_offsets, _neighbors, _n_vertices, _x, _y, _z, _stride, _eavg, _radius, true);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+RingTable::
+build(const unsigned int* _offsets, const unsigned int* _neighbors,
+      size_t _n_vertices, const float* _x, const float* _y,
+      const float* _z, size_t _stride, const float* _eavg,
+      float _reach, bool _geodesic)
+{
+  const long long  n(_n_vertices);
+
+  clear();
+  offsets_.resize(n+1);
+  offsets_[0] = 0;
+  reach_ = _reach;
+
+
+  // first pass counts the rows into offsets_[v+1], the second one fills
+  for (int fill=0; fill<2; ++fill)
+  {
+    if (fill)
+    {
+      for (long long v=0; v<n; ++v)
+        offsets_[v+1] += offsets_[v];
+      neighbors_.resize(offsets_[n]);
+      distances_.resize(offsets_[n]);
+    }
+
+#pragma omp parallel
+    {
+      Search  s;
+      bool    added;
+
+#pragma omp for schedule(dynamic, 256)
+      for (long long v=0; v<n; ++v)
+      {
+        unsigned int  count(0), out(fill ? offsets_[v] : 0);
+        s.reset();
+        s.visit(v, added) = 0.0f;
+
+        if (_geodesic)
+        {
+          // Dijkstra along the edges, up to the radius of v
+          const float  limit(_reach * _eavg[v]);
+          s.heap.push(std::make_pair(0.0f, (unsigned int)v));
+          while (!s.heap.empty())
+          {
+            const std::pair<float, unsigned int>  top(s.heap.top());
+            s.heap.pop();
+            if (top.first > s.visit(top.second, added)) continue;
+            if (top.second != v)
+            {
+              if (fill)
+              {
+                neighbors_[out] = top.second;
+                distances_[out] = top.first;
+                ++out;
+              }
+              ++count;
+            }
+
+            for (unsigned int i=_offsets[top.second]; i<_offsets[top.second+1]; ++i)
+            {
+              const unsigned int  j(_neighbors[i]);
+              const float         d(top.first + edge_length(_x, _y, _z, _stride, top.second, j));
+              if (d >= limit) continue;
+              float& dj = s.visit(j, added);
+              if (added || d < dj)
+              {
+                dj = d;
+                s.heap.push(std::make_pair(d, j));
+              }
+            }
+          }
+        }
+        else
+        {
+          // breadth-first, ring by ring
+          s.ring.assign(1, (unsigned int)v);
+          for (unsigned int k=0; k<(unsigned int)_reach && !s.ring.empty(); ++k)
+          {
+            s.next.clear();
+            for (size_t r=0; r<s.ring.size(); ++r)
+              for (unsigned int i=_offsets[s.ring[r]]; i<_offsets[s.ring[r]+1]; ++i)
+              {
+                const unsigned int  j(_neighbors[i]);
+                s.visit(j, added);
+                if (!added) continue;
+                s.next.push_back(j);
+                if (fill)
+                {
+                  neighbors_[out] = j;
+                  distances_[out] = edge_length(_x, _y, _z, _stride, v, j);
+                  ++out;
+                }
+                ++count;
+              }
+            s.ring.swap(s.next);
+          }
+        }
+
+        if (!fill)
+          offsets_[v+1] = count;
+      }
+    }
+  }
+}
+
+
+//=============================================================================
@@ -0,0 +1,137 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS RingTable
+//
+//=============================================================================
+
+
+#ifndef RING_TABLE_HH
+#define RING_TABLE_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include "Numa.hh"
+#include <vector>
+#include <stddef.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class RingTable RingTable.hh
+    Precomputed wide neighborhoods for the Gaussian convolution.
+
+    The MeshDOG convolution weighs the 1-ring only, so a wide Gaussian
+    takes many passes over the mesh. A RingTable holds for every vertex
+    the vertices up to k edges away (build_rings(), by breadth-first
+    search, with their Euclidean distances) or within a geodesic radius
+    of r average edge lengths (build_geodesic(), by Dijkstra along the
+    edges, with the path lengths), in compressed row format. One pass
+    over it replaces about reach()^2 passes over the 1-rings, see
+    passes(). This is an approximation: the widths are matched as if
+    every pass were a full Gaussian, whose variances add up, but a
+    1-ring step averages over the neighbors without the center and the
+    table cuts its Gaussian off at the reach, so the result is close to
+    the 1-ring convolutions, not equal.
+
+    The rows are built in parallel, each one by its own bounded search,
+    and trade memory, see bytes(), for fewer passes.
+**/
+
+class RingTable
+{
+public:
+
+  typedef std::vector<float, FirstTouchAllocator<float> >                Field;
+  typedef std::vector<unsigned int, FirstTouchAllocator<unsigned int> >  Indices;
+
+  RingTable();
+
+  /** the vertices at most _k edges from each vertex, itself excepted.
+      Vertex v has the 1-ring _neighbors[_offsets[v].._offsets[v+1]) and
+      the position (_x[v*_stride], _y[v*_stride], _z[v*_stride]). **/
+  void build_rings(const unsigned int* _offsets, const unsigned int* _neighbors,
+                   size_t _n_vertices, const float* _x, const float* _y,
+                   const float* _z, size_t _stride, unsigned int _k);
+
+  /// the vertices closer than _radius * _eavg[v] to each vertex v along
+  /// the edges, itself excepted
+  void build_geodesic(const unsigned int* _offsets, const unsigned int* _neighbors,
+                      size_t _n_vertices, const float* _x, const float* _y,
+                      const float* _z, size_t _stride, const float* _eavg,
+                      float _radius);
+
+  /// free the table
+  void clear();
+
+  bool empty() const { return offsets_.empty(); }
+
+  /// k or the radius it was built for, 0 when empty
+  float reach() const { return reach_; }
+
+  /// row of _v: neighbor(i) at distance(i) for i in [begin(_v), end(_v))
+  unsigned int begin(size_t _v) const { return offsets_[_v]; }
+  unsigned int end(size_t _v)   const { return offsets_[_v+1]; }
+  unsigned int neighbor(size_t _i) const { return neighbors_[_i]; }
+  float        distance(size_t _i) const { return distances_[_i]; }
+
+  /// entries of all rows
+  size_t n_entries() const { return neighbors_.size(); }
+
+  /// memory of the table
+  size_t bytes() const;
+
+  /** wide passes standing in for _steps 1-ring convolutions, and the
+      factor their Gaussian width gets so that the variances of full,
+      untruncated Gaussians would match **/
+  int passes(int _steps) const;
+  float theta_scale(int _steps) const;
+
+
+private:
+
+  // count the rows first, then fill them, the searches run twice
+  void build(const unsigned int* _offsets, const unsigned int* _neighbors,
+             size_t _n_vertices, const float* _x, const float* _y,
+             const float* _z, size_t _stride, const float* _eavg,
+             float _reach, bool _geodesic);
+
+  Indices  offsets_;     // n_vertices+1
+  Indices  neighbors_;   // per row in the order they were found
+  Field    distances_;   // Euclidean or along the edges
+  float    reach_;
+};
+
+
+//=============================================================================
+#endif // RING_TABLE_HH defined
+//=============================================================================
@@ -0,0 +1,165 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS ScratchArena - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "ScratchArena.hh"
+#include <algorithm>
+#include <new>
+#include <stdlib.h>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+ScratchArena::
+ScratchArena(size_t _block_size)
+  : current_(0), offset_(0), used_(0), high_water_(0),
+    block_size_(_block_size), n_allocations_(0)
+{
+}
+
+
+ScratchArena::
+~ScratchArena()
+{
+  release_blocks();
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+ScratchArena::
+add_block(size_t _min_size)
+{
+  Block block;
+  block.size = std::max(block_size_, (_min_size + 63) & ~(size_t)63);
+
+  void* data;
+  if (posix_memalign(&data, 64, block.size) != 0)
+    throw std::bad_alloc();
+  block.data = (char*)data;
+
+  blocks_.push_back(block);
+  ++n_allocations_;
+}
+
+
+void
+ScratchArena::
+release_blocks()
+{
+  for (size_t i=0; i<blocks_.size(); ++i)
+    free(blocks_[i].data);
+  blocks_.clear();
+  current_ = offset_ = used_ = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void*
+ScratchArena::
+allocate_bytes(size_t _bytes)
+{
+  const size_t bytes = (_bytes + 63) & ~(size_t)63;
+
+  // move on to the next block that is large enough, later blocks of a
+  // previous run are reused before new ones are added
+  while (current_ < blocks_.size() && offset_ + bytes > blocks_[current_].size)
+  {
+    used_ += blocks_[current_].size;
+    ++current_;
+    offset_ = 0;
+  }
+  if (current_ == blocks_.size())
+    add_block(bytes);
+
+  char* data = blocks_[current_].data + offset_;
+  offset_ += bytes;
+  high_water_ = std::max(high_water_, used_ + offset_);
+  return data;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+ScratchArena::Mark
+ScratchArena::
+mark() const
+{
+  Mark m = { current_, offset_ };
+  return m;
+}
+
+
+void
+ScratchArena::
+rewind(const Mark& _mark)
+{
+  for (; current_ > _mark.block; --current_)
+    used_ -= blocks_[current_-1].size;
+  offset_ = _mark.offset;
+
+
+  // completely free: merge the blocks into one, so the next run of the
+  // same size fits without allocating
+  if (current_ == 0 && offset_ == 0 && blocks_.size() > 1 && block_size_ > 0)
+  {
+    release_blocks();
+    add_block(high_water_);
+  }
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+size_t
+ScratchArena::
+capacity() const
+{
+  size_t size(0);
+  for (size_t i=0; i<blocks_.size(); ++i)
+    size += blocks_[i].size;
+  return size;
+}
+
+
+//=============================================================================
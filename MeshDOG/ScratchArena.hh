@@ -0,0 +1,144 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS ScratchArena
+//
+//=============================================================================
+
+
+#ifndef SCRATCH_ARENA_HH
+#define SCRATCH_ARENA_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include <vector>
+#include <stddef.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class ScratchArena ScratchArena.hh
+    Bump allocator for the temporaries of one pipeline run.
+
+    Arrays are carved from large blocks and given back all at once by
+    rewinding to a mark, usually through a Frame. When the arena is
+    rewound completely and had to grow on the way, its blocks are
+    replaced by a single one of the largest size used so far, so a
+    repeated run of the same size does not allocate at all. Only for
+    types that need no destructor.
+
+    A block size of 0 gives every array a block of its own and never
+    merges them, for an arena that lives for one run only, like the
+    fallback of MeshKernel without set_scratch(). BatchDOG keeps an
+    arena per worker for its kernel and DaemonDOG one for the cached
+    kernels, so a stream of meshes allocates the adjacency and feature
+    selection temporaries only when a mesh is larger than all before.
+    The viewer draws the color coding and detection temporaries from
+    its own.
+**/
+
+class ScratchArena
+{
+public:
+
+  /// position in the arena to rewind to
+  struct Mark
+  {
+    size_t block, offset;
+  };
+
+  /// rewinds the arena to where it was on construction
+  class Frame
+  {
+  public:
+    Frame(ScratchArena& _arena) : arena_(_arena), mark_(_arena.mark()) {}
+    ~Frame() { arena_.rewind(mark_); }
+  private:
+    Frame(const Frame&);
+    Frame& operator=(const Frame&);
+    ScratchArena&  arena_;
+    Mark           mark_;
+  };
+
+
+  ScratchArena(size_t _block_size = 1 << 20);
+  ~ScratchArena();
+
+  /// uninitialized array of _n elements, 64 byte aligned
+  template <class T>
+  T* allocate(size_t _n) { return static_cast<T*>(allocate_bytes(_n * sizeof(T))); }
+
+  /// uninitialized 64 byte aligned memory
+  void* allocate_bytes(size_t _bytes);
+
+  Mark mark() const;
+
+  /// give back everything allocated after _mark
+  void rewind(const Mark& _mark);
+
+  /// bytes of all blocks
+  size_t capacity() const;
+
+  /// most bytes in use at the same time
+  size_t high_water() const { return high_water_; }
+
+  /// number of blocks allocated so far
+  size_t n_allocations() const { return n_allocations_; }
+
+
+private:
+
+  ScratchArena(const ScratchArena&);
+  ScratchArena& operator=(const ScratchArena&);
+
+  struct Block
+  {
+    char*   data;
+    size_t  size;
+  };
+
+  void add_block(size_t _min_size);
+  void release_blocks();
+
+  std::vector<Block>  blocks_;
+  size_t              current_;     // block the next array comes from
+  size_t              offset_;      // used bytes of the current block
+  size_t              used_;        // used bytes of the blocks before it
+  size_t              high_water_;
+  size_t              block_size_;
+  size_t              n_allocations_;
+};
+
+
+//=============================================================================
+#endif // SCRATCH_ARENA_HH defined
+//=============================================================================
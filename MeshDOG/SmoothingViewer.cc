@@ -45,26 +45,24 @@
 SmoothingViewer::SmoothingViewer(const char* _title, int _width, int _height)
   : QualityViewer(_title, _width, _height)
 {
-    
-    mesh_.add_property(vpos_);
 }
 
 //-----------------------------------------------------------------------------
 
 void SmoothingViewer::keyboard(int key, int x, int y)
 {
+    // GlutViewer passes the special keys here too, the arrows and page
+    // keys (GLUT_KEY_LEFT .. GLUT_KEY_INSERT) are 'd' .. 'l', so no
+    // letters D to L
     switch (toupper(key))
     {
     case 'N':
         {
             std::cout << "10 Laplace-Beltrami smoothing iterations: " << std::flush;
             smooth(10);
-            calc_weights();
-            calc_mean_curvature();
-            calc_uniform_mean_curvature();
-            calc_gauss_curvature();
-            calc_triangle_quality();
-            face_color_coding();
+
+            // the fields are stale now, the draw mode recomputes what it shows
+            release_intermediate_fields();
 
             glutPostRedisplay();
             std::cout << "done\n";
@@ -74,12 +72,7 @@ void SmoothingViewer::keyboard(int key, int x, int y)
         {
             std::cout << "10 uniform smoothing iterations: " << std::flush;
             uniform_smooth(10);
-            calc_weights();
-            calc_mean_curvature();
-            calc_uniform_mean_curvature();
-            calc_gauss_curvature();
-            calc_triangle_quality();
-            face_color_coding();
+            release_intermediate_fields();
 
             glutPostRedisplay();
             std::cout << "done\n";
@@ -89,18 +82,111 @@ void SmoothingViewer::keyboard(int key, int x, int y)
         case 'M':
         {
             std::cout<<" Detecting MeshDOG features" << std::flush;
-            
-            std::cout<<"TODO" <<std::endl;
-            calc_weights();
-            calc_mean_curvature();
-            calc_uniform_mean_curvature();
-            calc_gauss_curvature();
-            calc_triangle_quality();
-            face_color_coding();
-            
-            
+            run_meshdog();
+            break;
+        }
+    case '+':
+        {
+            // one more convolution on top of the current level
+            ++_iters;
+            std::cout<<" MeshDOG scale level "<<_iters<<": " << std::flush;
+            run_meshdog();
+            break;
+        }
+    case '-':
+        {
+            // the levels only go forward, this starts over
+            if (_iters > 0) --_iters;
+            std::cout<<" MeshDOG scale level "<<_iters<<": " << std::flush;
+            run_meshdog();
+            break;
+        }
+
+    case '<':
+    case '>':
+        {
+            // one percent more or fewer feature points, from the ranking
+            // of the last detection
+            set_dog_fraction(dog_fraction() + (key == '>' ? 0.01 : -0.01));
+            std::cout << " MeshDOG threshold at " << 100.0*dog_fraction() << "%: "
+                      << _dog_feature_points.size() << " feature points\n";
+            save_meshdog();
             glutPostRedisplay();
-            std::cout << "done\n";
+            break;
+        }
+
+    case 'S':
+        {
+            // as many feature points as now, spread over a grid, or back
+            // to the threshold
+            if (dog_budget())
+                set_dog_fraction(dog_fraction());
+            else
+                set_dog_budget(_dog_feature_points.size());
+            std::cout << " MeshDOG " << (dog_budget() ? "grid" : "threshold")
+                      << " selection: " << _dog_feature_points.size() << " feature points\n";
+            save_meshdog();
+            glutPostRedisplay();
+            break;
+        }
+
+    case '[':
+    case ']':
+        {
+            // half an average edge length more or less between feature points
+            set_dog_radius(dog_radius() + (key == ']' ? 0.5f : -0.5f));
+            std::cout << " MeshDOG radius " << dog_radius() << " e_avg: "
+                      << _dog_feature_points.size() << " feature points\n";
+            save_meshdog();
+            glutPostRedisplay();
+            break;
+        }
+
+    case 'V':
+        {
+            // the next input function (vertex values) that is loaded,
+            // convolved alone
+            static const MeshView::Field_id functions[] = { MeshView::UNICURVATURE,
+                MeshView::CURVATURE, MeshView::GAUSSCURVATURE, MeshView::LUMINANCE,
+                MeshView::USER_FUNCTION };
+            const size_t n(sizeof(functions) / sizeof(functions[0]));
+            size_t       i(0);
+
+            while (i < n && functions[i] != view_.dog_channel_id(view_.dog_channel()))
+                ++i;
+            if (i == n) i = n - 1;
+            do i = (i + 1) % n;
+            while (!dog_function_available(functions[i]));
+
+            set_dog_channels(&functions[i], 1);
+            std::cout << " MeshDOG on " << MeshView::field_name(functions[i]) << ": " << std::flush;
+            run_meshdog();
+            break;
+        }
+
+    case 'C':
+        {
+            // the next of the functions convolved together
+            show_dog_channel((view_.dog_channel() + 1) % view_.n_dog_channels());
+            std::cout << " MeshDOG on " << MeshView::field_name(view_.dog_channel_id(view_.dog_channel()))
+                      << ": " << _dog_feature_points.size() << " feature points\n";
+            save_meshdog();
+            glutPostRedisplay();
+            break;
+        }
+
+    case 'P':
+        {
+            // distances (path lengths) from the feature points, shown right away
+            geodesic_distances(geodesics_time_);
+            set_draw_mode(geodesic_mode_);
+            glutPostRedisplay();
+            break;
+        }
+
+    case 'R':
+        {
+            memory_report();
             break;
         }
 
@@ -115,85 +201,40 @@ void SmoothingViewer::keyboard(int key, int x, int y)
 
 //-----------------------------------------------------------------------------
 
-void SmoothingViewer::smooth(unsigned int _iters)
+void SmoothingViewer::run_meshdog()
 {
-    Mesh::VertexIter        v_it, v_end(mesh_.vertices_end());
-    Mesh::HalfedgeHandle    h;
-    Mesh::EdgeHandle        e;
-    Mesh::VertexVertexIter  vv_it;
-    Mesh::Point             laplace(0.0, 0.0, 0.0);
-    Mesh::Scalar            w, ww;
-
-    // ------------- IMPLEMENT HERE ---------
-    // TASK 4.3.b Smoothing using the Laplace-Beltrami.
-    // Use eweight_ properties for the individual edge weights
-    // and their sum for the normalization term.
-    // ------------- IMPLEMENT HERE ---------
-    
-    Mesh::VertexOHalfedgeIter voh_it;
-    Mesh::VertexHandle vi;
-    Mesh::Point vvi;
-
-    for (int i = 0; i < _iters; ++i)
-    {
-        // calculate LB(v)
-        for (v_it = mesh_.vertices_begin(); v_it != v_end; ++v_it)
-        {
-            laplace[0] = laplace[1] = laplace[2] = ww = 0.0;
-            for(voh_it = mesh_.voh_iter(v_it); voh_it; ++voh_it)
-            {
-                // get vi handle and vi - v
-                vi = mesh_.to_vertex_handle(voh_it);
-                vvi = mesh_.point(vi) - mesh_.point(v_it);
-
-                // get edge handle where vi is on
-                e = mesh_.edge_handle(voh_it.handle());
-
-                // sum(wi * (vi - v))
-                laplace += mesh_.property(eweight_, e) * vvi;
-                ww += mesh_.property(eweight_, e);
-            }
-            
-            laplace = laplace / ww;
-            mesh_.point(v_it) = mesh_.point(v_it) + (laplace / 2);
-        }
-        mesh_.update_normals();
-    }
-
+    // on the current positions, computing only the stale fields and the
+    // convolutions past the level already reached
+    init_meshdog();
+    detect_meshdog(_iters);
+    save_meshdog();
+    release_intermediate_fields();
+
+    glutPostRedisplay();
+    std::cout << "done\n";
 }
 
 //-----------------------------------------------------------------------------
 
-void SmoothingViewer::uniform_smooth(unsigned int _iters)
+void SmoothingViewer::smooth(unsigned int _iters)
 {
-    Mesh::VertexIter        v_it, v_end(mesh_.vertices_end());
-    Mesh::VertexVertexIter  vv_it;
-    Mesh::Point             centroid(0.0, 0.0, 0.0);
-    unsigned                  w;
-
-    // ------------- IMPLEMENT HERE ---------
-    // TASK 4.1.b Smoothing using the uniform Laplacian approximation
-    // ------------- IMPLEMENT HERE ---------
+    // Laplace-Beltrami smoothing on the kernel view, using the EWEIGHT
+    // values of the current positions and their sum for normalization
+    view_.smooth(_iters);
+    view_.push_points(mesh_);
+    geodesics_.clear();
+    mesh_.update_normals();
+}
 
-    Mesh::Scalar counter;
-    for (int i = 0; i < _iters; ++i)
-    {
-        // calculate Lu(v)
-        for (v_it = mesh_.vertices_begin(); v_it != v_end; ++v_it)
-        {
-            centroid[0] = centroid[1] = centroid[2] = counter = 0.0;
-            for(vv_it = mesh_.vv_iter(v_it); vv_it; ++vv_it)
-            {
-                centroid += mesh_.point(vv_it);
-                counter++;
-            }
-            centroid = (centroid / counter) - mesh_.point(v_it);
-            mesh_.point(v_it) = mesh_.point(v_it) + (centroid / 2);
-        }
-        // update the normals
-        mesh_.update_normals();
+//-----------------------------------------------------------------------------
 
-    }
+void SmoothingViewer::uniform_smooth(unsigned int _iters)
+{
+    // smoothing using the uniform Laplacian approximation
+    view_.uniform_smooth(_iters);
+    view_.push_points(mesh_);
+    geodesics_.clear();
+    mesh_.update_normals();
 }
 
 //=============================================================================
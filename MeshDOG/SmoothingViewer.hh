@@ -61,14 +61,9 @@ private:
 
     virtual void keyboard(int key, int x, int y);
 
-
-    // easier access to new vertex positions
-    Mesh::Point& new_pos(Mesh::VertexHandle _vh) 
-    { return mesh_.property(vpos_, _vh); }
-
-private:
-
-    OpenMesh::VPropHandleT<Mesh::Point>   vpos_;
+    /// detect and save the features at scale level _iters, continuing
+    /// the scale space of an earlier run if the mesh did not change
+    void run_meshdog();
 };
 
 //=============================================================================
@@ -0,0 +1,201 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS SparseLDL - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "SparseLDL.hh"
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+SparseLDL::
+SparseLDL()
+{
+}
+
+
+void
+SparseLDL::
+clear()
+{
+  std::vector<unsigned int>().swap(order_);
+  std::vector<unsigned int>().swap(inverse_);
+  std::vector<unsigned int>().swap(offsets_);
+  std::vector<unsigned int>().swap(rows_);
+  std::vector<double>().swap(values_);
+  std::vector<double>().swap(diagonal_);
+}
+
+
+size_t
+SparseLDL::
+bytes() const
+{
+  return (order_.capacity() + inverse_.capacity() + offsets_.capacity() + rows_.capacity())
+    * sizeof(unsigned int) + (values_.capacity() + diagonal_.capacity()) * sizeof(double);
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+bool
+SparseLDL::
+factor(size_t _n, const unsigned int* _offsets, const unsigned int* _columns,
+       const double* _values, const std::vector<unsigned int>& _order)
+{
+  const unsigned int          none(~0u);
+  std::vector<unsigned int>   parent(_n), count(_n), flag(_n), pattern(_n);
+  std::vector<double>         y(_n, 0.0);
+
+  clear();
+  order_ = _order;
+  inverse_.resize(_n);
+  for (size_t k=0; k<_n; ++k)
+    inverse_[order_[k]] = k;
+
+
+  // symbolic: the elimination tree and the entries of every column of
+  // L, walking up the tree from each entry above the diagonal of row k
+  for (size_t k=0; k<_n; ++k)
+  {
+    const unsigned int r(order_[k]);
+    parent[k] = none;
+    flag[k]   = k;
+    count[k]  = 0;
+    for (unsigned int p=_offsets[r]; p<_offsets[r+1]; ++p)
+      for (unsigned int i=inverse_[_columns[p]]; i<k && flag[i]!=k; i=parent[i])
+      {
+        if (parent[i] == none) parent[i] = k;
+        ++count[i];
+        flag[i] = k;
+      }
+  }
+
+  offsets_.resize(_n+1);
+  offsets_[0] = 0;
+  for (size_t k=0; k<_n; ++k)
+    offsets_[k+1] = offsets_[k] + count[k];
+  rows_.resize(offsets_[_n]);
+  values_.resize(offsets_[_n]);
+  diagonal_.resize(_n);
+
+
+  // numeric: row k of L from a sparse triangular solve with the rows
+  // above it, in the topological order of the pattern on the tree
+  for (size_t k=0; k<_n; ++k)
+  {
+    const unsigned int  r(order_[k]);
+    size_t              top(_n);
+
+    flag[k]  = k;
+    count[k] = 0;
+    for (unsigned int p=_offsets[r]; p<_offsets[r+1]; ++p)
+    {
+      unsigned int i(inverse_[_columns[p]]);
+      if (i > k) continue;
+      y[i] += _values[p];
+
+      size_t len(0);
+      for (; flag[i]!=k; i=parent[i])
+      {
+        pattern[len++] = i;
+        flag[i] = k;
+      }
+      while (len > 0)
+        pattern[--top] = pattern[--len];
+    }
+
+    diagonal_[k] = y[k];
+    y[k] = 0.0;
+    for (; top<_n; ++top)
+    {
+      const unsigned int  i(pattern[top]);
+      const double        yi(y[i]);
+      const unsigned int  end(offsets_[i] + count[i]);
+      y[i] = 0.0;
+
+      for (unsigned int p=offsets_[i]; p<end; ++p)
+        y[rows_[p]] -= values_[p] * yi;
+
+      const double l(yi / diagonal_[i]);
+      diagonal_[k] -= l * yi;
+      rows_[end]   = k;
+      values_[end] = l;
+      ++count[i];
+    }
+
+    if (!(diagonal_[k] > 0.0))
+    {
+      clear();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+SparseLDL::
+solve(double* _x, double* _work) const
+{
+  const size_t n(diagonal_.size());
+
+  for (size_t k=0; k<n; ++k)
+    _work[k] = _x[order_[k]];
+
+  // L, D and L^T
+  for (size_t j=0; j<n; ++j)
+    for (unsigned int p=offsets_[j]; p<offsets_[j+1]; ++p)
+      _work[rows_[p]] -= values_[p] * _work[j];
+
+  for (size_t j=0; j<n; ++j)
+    _work[j] /= diagonal_[j];
+
+  for (size_t j=n; j-->0; )
+    for (unsigned int p=offsets_[j]; p<offsets_[j+1]; ++p)
+      _work[j] -= values_[p] * _work[rows_[p]];
+
+  for (size_t k=0; k<n; ++k)
+    _x[order_[k]] = _work[k];
+}
+
+
+//=============================================================================
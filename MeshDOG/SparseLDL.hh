@@ -0,0 +1,97 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  CLASS SparseLDL
+//
+//=============================================================================
+
+
+#ifndef SPARSE_LDL_HH
+#define SPARSE_LDL_HH
+
+
+//== INCLUDES =================================================================
+
+
+#include <vector>
+#include <stddef.h>
+
+
+//== CLASS DEFINITION =========================================================
+
+
+/** \class SparseLDL SparseLDL.hh
+    Sparse LDL^T factorization of a symmetric positive definite matrix.
+
+    The factor is computed row by row along the elimination tree of the
+    matrix in a given fill-reducing order (the up-looking algorithm of
+    T. Davis' LDL). It is kept, so every solve() is one forward and one
+    backward substitution; solve() only reads the factor and can run on
+    several threads at once, each with its own work array.
+**/
+
+class SparseLDL
+{
+public:
+
+  SparseLDL();
+
+  /** factor the n x n matrix with the entries _values[i] in the columns
+      _columns[i] of row r, i in [_offsets[r], _offsets[r+1]); the full
+      symmetric pattern or its upper triangle. Row _order[k] of the
+      matrix becomes row k of the factor. False if a pivot is not
+      positive. **/
+  bool factor(size_t _n, const unsigned int* _offsets, const unsigned int* _columns,
+              const double* _values, const std::vector<unsigned int>& _order);
+
+  /// solve in place, _work holds n values
+  void solve(double* _x, double* _work) const;
+
+  size_t n() const { return diagonal_.size(); }
+
+  /// off-diagonal entries of the factor
+  size_t n_entries() const { return rows_.size(); }
+
+  /// memory of the factor
+  size_t bytes() const;
+
+  void clear();
+
+
+private:
+
+  std::vector<unsigned int>  order_, inverse_;   // factor row -> matrix row and back
+  std::vector<unsigned int>  offsets_, rows_;     // columns of L
+  std::vector<double>        values_, diagonal_;
+};
+
+
+//=============================================================================
+#endif // SPARSE_LDL_HH defined
+//=============================================================================
@@ -0,0 +1,168 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  C interface of the MeshDOG detection - IMPLEMENTATION
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "meshdog.h"
+#include "MeshKernel.hh"
+#include <algorithm>
+#include <new>
+#include <string.h>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+/// copy a field to a caller buffer if there is one
+static void copy_field(const MeshKernel::Field& _field, float* _out)
+{
+  if (_out && !_field.empty())
+    memcpy(_out, &_field[0], _field.size() * sizeof(float));
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+void
+meshdog_default_params(meshdog_params* _params)
+{
+  if (!_params) return;
+  _params->iterations = 10;
+  _params->fraction   = 0.95;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+int
+meshdog_detect(const meshdog_mesh* _mesh, const meshdog_params* _params,
+               unsigned int* _features, size_t _capacity, size_t* _n_features,
+               const meshdog_fields* _fields)
+{
+  meshdog_params  params;
+
+  if (_params) params = *_params;
+  else         meshdog_default_params(&params);
+
+  if (_n_features) *_n_features = 0;
+
+
+  // the arrays have to be there and their strides float and index aligned
+  if (!_mesh || !_n_features || (_capacity && !_features) ||
+      params.iterations < 0 || params.fraction < 0.0 || params.fraction > 1.0)
+    return MESHDOG_INVALID_ARGUMENT;
+
+  const size_t nv(_mesh->n_vertices), nt(_mesh->n_triangles);
+  const size_t ps(_mesh->position_stride ? _mesh->position_stride : 3*sizeof(float));
+  const size_t is(_mesh->index_stride    ? _mesh->index_stride    : 3*sizeof(unsigned int));
+
+  if ((nv && !_mesh->positions) || (nt && !_mesh->indices) ||
+      ps < 3*sizeof(float) || ps % sizeof(float) ||
+      is < 3*sizeof(unsigned int) || is % sizeof(unsigned int))
+    return MESHDOG_INVALID_ARGUMENT;
+
+  for (size_t t=0; t<nt; ++t)
+  {
+    const unsigned int* f = _mesh->indices + t * (is / sizeof(unsigned int));
+    if (f[0] >= nv || f[1] >= nv || f[2] >= nv)
+      return MESHDOG_INVALID_ARGUMENT;
+  }
+
+  if (nv == 0)
+    return MESHDOG_OK;
+
+
+  // the same pipeline as the other flat-array front ends
+  try
+  {
+    MeshKernel                 kernel;
+    MeshKernel::Field          f, eavg, dog;
+    std::vector<unsigned int>  features;
+
+    kernel.attach(_mesh->positions, nv, ps / sizeof(float),
+                  _mesh->indices, nt, is / sizeof(unsigned int));
+    kernel.calc_uniform_mean_curvature(f);
+    kernel.calc_edge_average(eavg);
+
+    if (_fields)
+    {
+      copy_field(f, _fields->curvature);
+      copy_field(eavg, _fields->edge_average);
+    }
+
+    kernel.detect_meshdog(params.iterations, eavg, f, dog);
+    kernel.select_features(dog, params.fraction, features);
+
+    if (_fields)
+      copy_field(dog, _fields->dog);
+
+    *_n_features = features.size();
+    if (!features.empty())
+      memcpy(_features, &features[0], std::min(_capacity, features.size()) * sizeof(unsigned int));
+
+    return features.size() > _capacity ? MESHDOG_BUFFER_TOO_SMALL : MESHDOG_OK;
+  }
+  catch (const std::bad_alloc&)
+  {
+    return MESHDOG_OUT_OF_MEMORY;
+  }
+  catch (...)
+  {
+    return MESHDOG_INTERNAL_ERROR;
+  }
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+const char*
+meshdog_status_string(int _status)
+{
+  switch (_status)
+  {
+    case MESHDOG_OK:                return "ok";
+    case MESHDOG_INVALID_ARGUMENT:  return "invalid argument";
+    case MESHDOG_BUFFER_TOO_SMALL:  return "feature buffer too small";
+    case MESHDOG_OUT_OF_MEMORY:     return "out of memory";
+    case MESHDOG_INTERNAL_ERROR:    return "internal error";
+    default:                        return "unknown status";
+  }
+}
+
+
+//=============================================================================
@@ -0,0 +1,131 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  C interface of the MeshDOG detection
+//
+//=============================================================================
+
+
+#ifndef MESHDOG_H
+#define MESHDOG_H
+
+
+//== INCLUDES =================================================================
+
+
+#include <stddef.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//== DECLARATIONS =============================================================
+
+
+/** Runs the MeshDOG detection on meshes held in the caller's memory.
+
+    The positions and triangles are read in place through the given
+    strides, nothing is written to disk and no OpenMesh copy is made.
+    The only allocations are the adjacency and the per-vertex working
+    fields of the kernels. All functions are safe to call from several
+    threads on different meshes.
+
+    Every convolution updates all vertices from the previous level
+    (Jacobi), as the batch, daemon, out-of-core and process front ends
+    do. The interactive viewer updates in place by default, its features
+    match these with -jacobi only. A NaN DoG, e.g. from a degenerate
+    triangle, ranks as 0 for the threshold and is never a feature.
+**/
+
+
+/// results of the functions
+enum meshdog_status
+{
+  MESHDOG_OK = 0,
+  MESHDOG_INVALID_ARGUMENT,   ///< null pointers, bad strides or indices
+  MESHDOG_BUFFER_TOO_SMALL,   ///< more features than the buffer holds
+  MESHDOG_OUT_OF_MEMORY,
+  MESHDOG_INTERNAL_ERROR
+};
+
+
+/// caller-owned mesh arrays, only read
+typedef struct meshdog_mesh
+{
+  const float*         positions;        ///< x, y, z of the first vertex
+  size_t               n_vertices;
+  size_t               position_stride;  ///< bytes between vertices, 0 for 3 floats
+  const unsigned int*  indices;          ///< three vertex indices of the first triangle
+  size_t               n_triangles;
+  size_t               index_stride;     ///< bytes between triangles, 0 for 3 indices
+} meshdog_mesh;
+
+
+/// detection parameters
+typedef struct meshdog_params
+{
+  int     iterations;   ///< Gaussian convolutions, 10 by default
+  double  fraction;     ///< fraction of vertices below the DoG threshold, 0.95
+} meshdog_params;
+
+
+/// optional per-vertex outputs, n_vertices floats each or null
+typedef struct meshdog_fields
+{
+  float*  curvature;      ///< uniform mean curvature the detection starts from
+  float*  edge_average;   ///< average length of the edges around each vertex
+  float*  dog;            ///< difference of the last two convolution levels
+} meshdog_fields;
+
+
+/// fill _params with the defaults
+void meshdog_default_params(meshdog_params* _params);
+
+/** detect the features of _mesh. Their vertex indices go to _features,
+    at most _capacity of them, *_n_features receives their number; with
+    MESHDOG_BUFFER_TOO_SMALL the first _capacity are written. _params
+    and _fields may be null. **/
+int meshdog_detect(const meshdog_mesh* _mesh, const meshdog_params* _params,
+                   unsigned int* _features, size_t _capacity, size_t* _n_features,
+                   const meshdog_fields* _fields);
+
+/// readable text of a status
+const char* meshdog_status_string(int _status);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+//=============================================================================
+#endif // MESHDOG_H defined
+//=============================================================================
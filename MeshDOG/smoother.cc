@@ -31,21 +31,373 @@
 //                                                                            
 //=============================================================================
 #include "SmoothingViewer.hh"
+#include "MeshLoader.hh"
+#include "PatchDOG.hh"
+#include "PartitionDOG.hh"
+#include "Numa.hh"
+#include "HugePageArena.hh"
+#include "CompactMesh.hh"
+#include "BatchDOG.hh"
+#include "DaemonDOG.hh"
+#include <algorithm>
+#include <string>
+
+
+// write feature positions (dog_points.ply) and indices (dog_points.txt)
+static void save_features(const float* _points, const std::vector<unsigned int>& _features)
+{
+  if (!BatchDOG::write_features("dog_points", _points, _features))
+    std::cout<<"Failed to save the feature points!"<<std::endl;
+}
+
+
+// the MeshDOG input functions of a comma separated list, anything but
+// a name is a file of per-vertex values
+static size_t parse_functions(const std::string& _list, MeshView::Field_id* _ids,
+                              std::string& _file)
+{
+  size_t  n(0), begin(0), end;
+
+  do
+  {
+    end = _list.find(',', begin);
+    const std::string name(_list, begin, end == std::string::npos ? std::string::npos : end - begin);
+    begin = end + 1;
+
+    if (name.empty() || n == MeshView::max_dog_channels) continue;
+    if (name == "uniform")    _ids[n++] = MeshView::UNICURVATURE;
+    else if (name == "mean")  _ids[n++] = MeshView::CURVATURE;
+    else if (name == "gauss") _ids[n++] = MeshView::GAUSSCURVATURE;
+    else if (name == "color") _ids[n++] = MeshView::LUMINANCE;
+    else
+    {
+      _file = name;
+      _ids[n++] = MeshView::USER_FUNCTION;
+    }
+  }
+  while (end != std::string::npos);
+
+  return n;
+}
+
+
+// read a mesh into flat arrays, welding soups and on request
+static bool read_flat(MeshLoader& _loader, const char* _filename,
+                      bool _weld, float _weld_epsilon)
+{
+  if (!_loader.read(_filename))
+  {
+    std::cerr << "cannot read " << _filename << std::endl;
+    return false;
+  }
+  if (_weld || _loader.is_soup())
+    _loader.weld(_weld_epsilon);
+  return true;
+}
+
+
+// detect features patch by patch, without OpenMesh and without a window;
+// the input itself is in memory, only the detector's arrays are paged
+static int run_out_of_core(const char* _filename, int _iters, double _fraction,
+                           size_t _patch_size, bool _weld, float _weld_epsilon)
+{
+  MeshLoader              loader;
+  PatchDOG                detector;
+  std::vector<unsigned>   features;
+
+  if (!read_flat(loader, _filename, _weld, _weld_epsilon))
+    return 1;
+
+  detector.set_iterations(_iters);
+  detector.set_fraction(_fraction);
+  detector.set_patch_size(_patch_size);
+  if (!detector.detect(loader.points(), loader.n_vertices(),
+                       loader.faces(), loader.n_faces(), features))
+    return 1;
+  HugePageArena::report(std::cerr);
+
+  save_features(loader.points(), features);
+  return 0;
+}
+
+
+// detect features in several worker processes, without a window
+static int run_partitioned(const char* _filename, int _iters, double _fraction,
+                           int _processes, bool _weld, float _weld_epsilon)
+{
+  MeshLoader              loader;
+  PartitionDOG            detector;
+  std::vector<unsigned>   features;
+
+  if (!read_flat(loader, _filename, _weld, _weld_epsilon))
+    return 1;
+
+  detector.set_iterations(_iters);
+  detector.set_fraction(_fraction);
+  detector.set_processes(_processes);
+  if (!detector.detect(loader.points(), loader.n_vertices(),
+                       loader.faces(), loader.n_faces(), features))
+    return 1;
+
+  save_features(loader.points(), features);
+  return 0;
+}
+
+
+// detect features on a CompactMesh, without a window
+static int run_compact(const char* _filename, int _iters, double _fraction, bool _weld, float _weld_epsilon)
+{
+  CompactMesh             mesh;
+  std::vector<float>      points;
+  std::vector<unsigned>   features;
+  {
+    MeshLoader loader;
+    if (!read_flat(loader, _filename, _weld, _weld_epsilon))
+      return 1;
+    mesh.set_mesh(loader.points(), loader.n_vertices(), loader.faces(), loader.n_faces());
+  }
+
+  mesh.detect(_iters, _fraction, features);
+  std::cerr << features.size() << " features, " << mesh.n_uncertain()
+            << " vertices within " << mesh.feature_band() << " of the threshold, "
+            << mesh.bytes() << " bytes resident instead of " << mesh.full_bytes() << std::endl;
+
+  mesh.points(points);
+  save_features(points.empty() ? 0 : &points[0], features);
+  return 0;
+}
+
+
+// detect features of all meshes of a directory or manifest, without a window
+static int run_batch(const char* _path, int _iters, double _fraction, size_t _budget,
+                     unsigned int _grid, float _radius, unsigned int _rings, float _geodesic,
+                     int _workers, const char* _output, bool _weld, float _weld_epsilon)
+{
+  BatchDOG                   batch;
+  std::vector<std::string>   files;
+
+  if (!BatchDOG::list_inputs(_path, files))
+    return 1;
+
+  batch.set_iterations(_iters);
+  batch.set_fraction(_fraction);
+  batch.set_uniform(_budget, _grid);
+  batch.set_radius(_radius);
+  batch.set_rings(_rings);
+  batch.set_geodesic(_geodesic);
+  batch.set_workers(_workers);
+  batch.set_output(_output);
+  if (_weld)
+    batch.set_weld_epsilon(_weld_epsilon);
+  return batch.run(files) ? 0 : 1;
+}
 
 
 int main(int argc, char **argv)
 {
-  
+  std::cout<< "MeshDOG [-reorder morton|rcm] [-cache] [-openmesh] [-weld eps] [-outofcore patch_vertices] [-processes n] [-pin close|spread] [-hugepages off|thp|explicit] [-compact] [-fieldbudget mb] [-percentile p] [-threshold dog] [-uniform budget [-grid cells]] [-radius eavgs] [-rings k | -geodesic eavgs] [-jacobi] [-function uniform|mean|gauss|color|file[,...]] [-batch dir|manifest [-workers n] [-out dir]] [-daemon socket [-cachesize mb]] [-query socket request] /path/to/mehs [num of iters]"<<std::endl;
+  std::cout<< "  the viewer updates the DoG in place, -jacobi gives the update of the windowless modes and their features"<<std::endl;
+  std::cout<< "  -outofcore pages out the work arrays only: the mesh is read into memory (binary PLY positions stay mapped from the file), -cache is not used"<<std::endl;
+
+  const char*                 filename = 0;
+  const char*                 batch = 0;
+  const char*                 output = ".";
+  const char*                 daemon = 0;
+  const char*                 query = 0;
+  const char*                 request = 0;
+  int                         iters = 10;
+  double                      fraction = 0.95;
+  float                       threshold = 0.0f;
+  bool                        use_threshold = false;
+  size_t                      budget = 0;
+  unsigned int                grid = 0;
+  float                       radius = 0.0f, geodesic = 0.0f;
+  unsigned int                rings = 1;
+  MeshView::Field_id          functions[MeshView::max_dog_channels];
+  size_t                      n_functions = 0;
+  std::string                 function_file;
+  MeshViewer::Reorder_mode    reorder = MeshViewer::REORDER_NONE;
+  bool                        cache = false, native_loader = true, weld = false, compact = false;
+  bool                        jacobi = false;
+  float                       weld_epsilon = 0.0f;
+  size_t                      patch_size = 0, field_budget = 0, cache_size = 1024;
+  int                         processes = 0, workers = 0;
+  Numa::Pin_mode              pin = Numa::PIN_NONE;
+  HugePageArena::Mode         huge_pages = HugePageArena::HUGE_TRANSPARENT;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg(argv[i]);
+    if (arg == "-reorder" && i+1 < argc)
+    {
+      std::string mode(argv[++i]);
+      if (mode == "morton")   reorder = MeshViewer::REORDER_MORTON;
+      else if (mode == "rcm") reorder = MeshViewer::REORDER_RCM;
+      else std::cerr << "unknown vertex order " << mode << std::endl;
+    }
+    else if (arg == "-cache")
+      cache = true;
+    else if (arg == "-compact")
+      compact = true;
+    else if (arg == "-openmesh")
+      native_loader = false;
+    else if (arg == "-jacobi")
+      jacobi = true;
+    else if (arg == "-weld" && i+1 < argc)
+    {
+      weld = true;
+      weld_epsilon = std::atof(argv[++i]);
+    }
+    else if (arg == "-outofcore" && i+1 < argc)
+      patch_size = std::atol(argv[++i]);
+    else if (arg == "-fieldbudget" && i+1 < argc)
+      field_budget = size_t(std::atol(argv[++i])) << 20;
+    else if (arg == "-percentile" && i+1 < argc)
+    {
+      // 95 and 0.95 mean the same
+      fraction = std::atof(argv[++i]);
+      if (fraction > 1.0) fraction /= 100.0;
+    }
+    else if (arg == "-threshold" && i+1 < argc)
+    {
+      use_threshold = true;
+      threshold = std::atof(argv[++i]);
+    }
+    else if (arg == "-uniform" && i+1 < argc)
+      budget = std::atol(argv[++i]);
+    else if (arg == "-grid" && i+1 < argc)
+      grid = std::atoi(argv[++i]);
+    else if (arg == "-radius" && i+1 < argc)
+      radius = std::atof(argv[++i]);
+    else if (arg == "-rings" && i+1 < argc)
+      rings = std::atoi(argv[++i]);
+    else if (arg == "-geodesic" && i+1 < argc)
+      geodesic = std::atof(argv[++i]);
+    else if (arg == "-function" && i+1 < argc)
+      n_functions = parse_functions(argv[++i], functions, function_file);
+    else if (arg == "-batch" && i+1 < argc)
+      batch = argv[++i];
+    else if (arg == "-workers" && i+1 < argc)
+      workers = std::atoi(argv[++i]);
+    else if (arg == "-out" && i+1 < argc)
+      output = argv[++i];
+    else if (arg == "-daemon" && i+1 < argc)
+      daemon = argv[++i];
+    else if (arg == "-cachesize" && i+1 < argc)
+      cache_size = std::atol(argv[++i]);
+    else if (arg == "-query" && i+2 < argc)
+    {
+      query   = argv[++i];
+      request = argv[++i];
+    }
+    else if (arg == "-processes" && i+1 < argc)
+      processes = std::atoi(argv[++i]);
+    else if (arg == "-pin" && i+1 < argc)
+    {
+      std::string mode(argv[++i]);
+      if (mode == "close")       pin = Numa::PIN_CLOSE;
+      else if (mode == "spread") pin = Numa::PIN_SPREAD;
+      else std::cerr << "unknown pinning " << mode << std::endl;
+    }
+    else if (arg == "-hugepages" && i+1 < argc)
+    {
+      std::string mode(argv[++i]);
+      if (mode == "off")           huge_pages = HugePageArena::HUGE_OFF;
+      else if (mode == "thp")      huge_pages = HugePageArena::HUGE_TRANSPARENT;
+      else if (mode == "explicit") huge_pages = HugePageArena::HUGE_EXPLICIT;
+      else std::cerr << "unknown huge page mode " << mode << std::endl;
+    }
+    else if (!filename && !batch && !daemon)
+      filename = argv[i];
+    else
+      iters = std::atoi(argv[i]);
+  }
+
+  // the windowless modes take a subset of the options, the rest would
+  // be ignored silently; the daemon gets them with each request
+  const char* mode = query ? "-query" : daemon ? "-daemon" : batch ? "-batch"
+                   : !filename ? 0 : patch_size ? "-outofcore"
+                   : processes > 0 ? "-processes" : compact ? "-compact" : 0;
+  if (mode)
+  {
+    std::string unsupported;
+    if (use_threshold)
+      unsupported += " -threshold";
+    if (n_functions)
+      unsupported += " -function";
+    if (budget && !batch)
+      unsupported += " -uniform";
+    if (radius > 0.0f && !batch)
+      unsupported += " -radius";
+    if ((rings > 1 || geodesic > 0.0f) && !batch)
+      unsupported += " -rings/-geodesic";
+    if (!unsupported.empty())
+    {
+      std::cerr << mode << " does not take" << unsupported << std::endl;
+      return 1;
+    }
+  }
+
+  HugePageArena::set_mode(huge_pages);
+  if (!Numa::pin_threads(pin))
+    std::cerr << "cannot pin the threads" << std::endl;
+
+  // modes without a window
+  if (query)
+    return DaemonDOG::query(query, request, std::cout) ? 0 : 1;
+  if (daemon)
+  {
+    DaemonDOG server;
+    server.set_iterations(iters);
+    server.set_budget(cache_size << 20);
+    if (weld)
+      server.set_weld_epsilon(weld_epsilon);
+    server.set_compact(compact);
+    return server.serve(daemon) ? 0 : 1;
+  }
+  if (batch)
+    return run_batch(batch, iters, fraction, budget, grid, radius, rings, geodesic, workers, output, weld, weld_epsilon);
+  if (filename && patch_size)
+    return run_out_of_core(filename, iters, fraction, patch_size, weld, weld_epsilon);
+  if (filename && processes > 0)
+    return run_partitioned(filename, iters, fraction, processes, weld, weld_epsilon);
+  if (filename && compact)
+    return run_compact(filename, iters, fraction, weld, weld_epsilon);
+
+
   glutInit(&argc, argv);
 
   SmoothingViewer window("MeshDOG", 512, 512);
-  
-  std::cout<< "MeshDOG /path/to/mehs [num of iters]"<<std::endl;
-  if (argc>1)
+
+  window._iters = iters;
+  window.set_reorder_mode(reorder);
+  window.set_use_cache(cache);
+  window.set_native_loader(native_loader);
+  window.set_field_budget(field_budget);
+  window.set_dog_fraction(fraction);
+  if (use_threshold)
+    window.set_dog_threshold(threshold);
+  if (budget)
+    window.set_dog_budget(budget, grid);
+  window.set_dog_radius(radius);
+  if (geodesic > 0.0f)
+    window.set_dog_geodesic(geodesic);
+  else
+    window.set_dog_rings(rings);
+  window.set_dog_jacobi(jacobi);
+  if (weld)
+    window.set_weld_epsilon(weld_epsilon);
+  if (n_functions)
   {
-    window._iters = std::atoi(argv[2]);
-    window.open_mesh(argv[1]);
+    // the first one gives the feature points, 'C' shows the others
+    window.set_dog_channels(functions, n_functions);
+    window.set_dog_function_file(function_file.c_str());
+    window.set_read_colors(std::find(functions, functions + n_functions, MeshView::LUMINANCE)
+                           != functions + n_functions);
   }
 
+  if (filename)
+    window.open_mesh(filename);
+
   glutMainLoop();
 }
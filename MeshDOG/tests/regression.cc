@@ -0,0 +1,151 @@
+//=============================================================================
+//                                                                            
+//   MeshDOG
+//
+//   Feature detection on triangle meshes, built on the code framework
+//   for the lecture "Surface Representation and Geometric Modeling"
+//                                                                            
+//-----------------------------------------------------------------------------
+//                                                                            
+//                                License                                     
+//                                                                            
+//   This program is free software; you can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//   
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//   
+//   You should have received a copy of the GNU General Public License
+//   along with this program; if not, write to the Free Software
+//   Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+//   Boston, MA  02110-1301, USA.
+//                                                                            
+//=============================================================================
+//=============================================================================
+//
+//  Regression check: the patch and process front ends against MeshKernel
+//
+//=============================================================================
+
+
+//== INCLUDES =================================================================
+
+
+#include "MeshKernel.hh"
+#include "PartitionDOG.hh"
+#include "PatchDOG.hh"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <math.h>
+
+
+//== IMPLEMENTATION ========================================================== 
+
+
+/// _n x _n grid over a bumpy height field, the triangles in a scrambled
+/// order so the results cannot depend on it
+static void make_mesh(int _n, std::vector<float>& _points, std::vector<unsigned int>& _faces)
+{
+  _points.clear();
+  _faces.clear();
+
+  for (int i=0; i<_n; ++i)
+    for (int j=0; j<_n; ++j)
+    {
+      _points.push_back(i);
+      _points.push_back(j);
+      _points.push_back(3.0f*sinf(i*0.3f)*cosf(j*0.37f) + 0.2f*sinf(i*j*1.7f));
+    }
+
+  for (int i=0; i+1<_n; ++i)
+    for (int j=0; j+1<_n; ++j)
+    {
+      const unsigned int a(i*_n+j), b(a+1), c(a+_n), d(c+1);
+      const unsigned int t[] = { a, b, d, a, d, c };
+      _faces.insert(_faces.end(), t, t+6);
+    }
+
+  const size_t nf(_faces.size() / 3);
+  for (size_t f=0; f<nf; f+=7)
+    std::swap_ranges(&_faces[3*f], &_faces[3*f+3], &_faces[3*((f*7919) % nf)]);
+}
+
+
+/// compare and report one front end, true if the features match
+static bool check(const char* _name, int _parameter, bool _ok,
+                  const std::vector<unsigned int>& _features,
+                  const std::vector<unsigned int>& _reference)
+{
+  const bool same = _ok && _features == _reference;
+  std::cout << (same ? "ok     " : "FAILED ") << _name << " " << _parameter << ": "
+            << _features.size() << " of " << _reference.size() << " features" << std::endl;
+  return same;
+}
+
+
+//-----------------------------------------------------------------------------
+
+
+int main()
+{
+  const int                  iters(5);
+  const double               fraction(0.95);
+  std::vector<float>         points;
+  std::vector<unsigned int>  faces, reference, features;
+  bool                       ok(true);
+
+  // a few thousand vertices
+  make_mesh(60, points, faces);
+  const size_t nv(points.size() / 3), nf(faces.size() / 3);
+
+
+  // whole mesh
+  MeshKernel         kernel;
+  MeshKernel::Field  f, eavg, dog;
+
+  kernel.set_mesh(&points[0], nv, &faces[0], nf);
+  kernel.calc_uniform_mean_curvature(f);
+  kernel.calc_edge_average(eavg);
+  kernel.detect_meshdog(iters, eavg, f, dog);
+  kernel.select_features(dog, fraction, reference);
+  if (reference.empty())
+  {
+    std::cout << "FAILED no reference features" << std::endl;
+    return 1;
+  }
+
+
+  // patches far smaller than the mesh, halos included
+  const size_t patch_sizes[] = { 100, 500, 2000 };
+  for (size_t i=0; i<sizeof(patch_sizes)/sizeof(patch_sizes[0]); ++i)
+  {
+    PatchDOG patches;
+    patches.set_iterations(iters);
+    patches.set_fraction(fraction);
+    patches.set_patch_size(patch_sizes[i]);
+    ok &= check("PatchDOG patch size", patch_sizes[i],
+                patches.detect(&points[0], nv, &faces[0], nf, features), features, reference);
+  }
+
+
+  // worker processes
+  for (int n=1; n<=4; ++n)
+  {
+    PartitionDOG partition;
+    partition.set_iterations(iters);
+    partition.set_fraction(fraction);
+    partition.set_processes(n);
+    ok &= check("PartitionDOG processes", n,
+                partition.detect(&points[0], nv, &faces[0], nf, features), features, reference);
+  }
+
+  return ok ? 0 : 1;
+}
+
+
+//=============================================================================